@@ -25,79 +25,244 @@
 #define EVENT_DATA_VERSION (int32_t)201406171
 #define EVENT_DURATION (uint32_t)(15 * 60) /* TODO Use per-event times. */
 
+/* Alert for reminders at 10:00, 5:00, and 0:01 before event start. The
+ * phone's timeline pins cover the early alerts once it has the list. */
+#define EVENT_ALERT_EARLY (uint32_t)600
+#define EVENT_ALERT_LATE  (uint32_t)300
+#define EVENT_ALERT_START (uint32_t)1
+
 static const struct event event_info[EVENT_COUNT]; /* Defined below. */
 static uint32_t event_times[EVENT_COUNT] = { 0 };
 static bool event_reminders[EVENT_COUNT] = { false };
+static bool event_reminders_unsent = true;
+static bool event_reminders_synced = false;
+static bool event_reminders_unsaved = false;
+
+/* Local start times in minutes past midnight, only redone on tz changes. */
+static uint16_t event_starts[EVENT_COUNT] = { 0 };
+
+/* Each menu row is a group of events. Normally that's just one event per
+ * group, but simultaneous events can share a row. group_starts[] holds
+ * the array index of the first event in each group. */
+static uint8_t group_starts[EVENT_COUNT] = { 0 };
+static uint8_t group_count = 0;
+
+/* All the event tables put together, not counting strings. */
+#define EVENT_MEMORY_SIZE (sizeof(event_info) + sizeof(event_times) + sizeof(event_reminders) + \
+                           sizeof(event_starts) + sizeof(group_starts))
+
+BUILD_ASSERT(EVENT_MEMORY_SIZE <= MEMORY_BUDGET_EVENTS, event_tables_fit_budget);
 
 /*****************************************************************************/
 
-/* Find and return the desired event's array index. */
-static uint8_t get_event_index( const bool active, const uint8_t offset ){
-    uint8_t index = EVENT_INDEX_MAX;
+/* Build the group index, optionally merging events with the same start. */
+void set_event_grouping( const bool grouped ){
+    uint8_t index = 0;
+
+    group_count = 0;
+    for ( index = 0 ; index <= EVENT_INDEX_MAX ; index++ ){
+        if ( grouped == true && index > 0 &&
+             event_info[index].hour == event_info[index - 1].hour &&
+             event_info[index].min  == event_info[index - 1].min )
+            continue;
+
+        group_starts[group_count++] = index;
+    }
+}
+
+/*****************************************************************************/
+
+/* Work out the local start time of each event. */
+static void update_event_starts( void ){
+    uint8_t index = 0;
+
+    for ( index = 0 ; index <= EVENT_INDEX_MAX ; index++ ){
+        /* We need a representation of the event start time, so make one.
+         * It also needs to be adjusted for the current time zone. Argh. :S */
+        /* FIXME Someday, Pebble might have a working timezone system. :( */
+        struct tm event_tm = { 0 };
+        event_tm.tm_year = 112; /* bad_mktime() has issues with 1900. ;) */
+        event_tm.tm_hour = event_info[index].hour;
+        event_tm.tm_min  = event_info[index].min;
+        time_convert_utc_to_local(&event_tm);
+
+        event_starts[index] = (event_tm.tm_hour * 60) + event_tm.tm_min;
+    }
+}
+
+static void event_state_changed( const uint8_t changes, void *context ){
+    if ( changes & STATE_TZ_OFFSET )
+        update_event_starts();
+
+    /* Reminders need to go to the phone and storage when they change. */
+    if ( changes & STATE_REMINDERS ){
+        event_reminders_unsent = true;
+        event_reminders_synced = false;
+        event_reminders_unsaved = true;
+    }
+}
+
+/* Start keeping our cached event data in step with state changes. */
+void subscribe_event_state( void ){
+    state_subscribe(STATE_TZ_OFFSET | STATE_REMINDERS, event_state_changed, NULL);
+    update_event_starts();
+}
+
+/*****************************************************************************/
+
+/* Return the number of events in a group. */
+static uint8_t get_group_size( const uint8_t group ){
+    if ( group + 1 < group_count )
+        return group_starts[group + 1] - group_starts[group];
+
+    return EVENT_COUNT - group_starts[group];
+}
+
+/* Return the timer for a group. All its events start at the same time. */
+static uint32_t get_group_timer( const uint8_t group ){
+    return event_times[group_starts[group]];
+}
+
+/* Returns true if any event in the group has a reminder set. */
+static bool get_group_reminder( const uint8_t group ){
+    uint8_t index = 0;
+
+    for ( index = 0 ; index < get_group_size(group) ; index++ )
+        if ( event_reminders[group_starts[group] + index] == true )
+            return true;
+
+    return false;
+}
+
+/*****************************************************************************/
+
+/* Find the group number of the next upcoming event. */
+static uint8_t get_first_group( void ){
+    uint8_t group = group_count - 1;
 
     /* Start at the end of the list and count up. Break at
      * the first entry that's larger than the previous entry. */
-    for ( index = EVENT_INDEX_MAX ; index > 0 ; index-- )
-        if ( event_times[index] < event_times[index - 1] )
+    for ( group = group_count - 1 ; group > 0 ; group-- )
+        if ( get_group_timer(group) < get_group_timer(group - 1) )
             break;
 
+    return group;
+}
+
+/* Find and return the desired row's group number. */
+static uint8_t get_group( const bool active, const uint8_t offset ){
+    uint8_t group = get_first_group();
+
     /* Count backwards for active events. */
     if ( active == true ){
         uint8_t count = get_event_count(active);
-        if ( index - (count - offset) < 0 )
-            return EVENT_COUNT - ((count - index) - offset);
+        if ( group - (count - offset) < 0 )
+            return group_count - ((count - group) - offset);
 
-        return index - (count - offset);
+        return group - (count - offset);
     }
 
-    /* Wrap the index if it goes over the end of the array. */
-    if ( index + offset > EVENT_INDEX_MAX )
-        return (index + offset) - EVENT_COUNT;
+    /* Wrap the group if it goes over the end of the array. */
+    if ( group + offset >= group_count )
+        return (group + offset) - group_count;
 
-    return index + offset;
+    return group + offset;
 }
 
 /*****************************************************************************/
 
-/* Return the number of events in the list. */
+/* Return the number of rows in the list. */
 uint8_t get_event_count( const bool active ){
-    uint8_t index = 0;
+    uint8_t group = 0;
     uint8_t count = 0;
 
     /* Consider an event active if it's x-minutes less than 24-hours away. */
-    for ( index = 0 ; index <= EVENT_INDEX_MAX ; index++ )
-        if ( event_times[index] > (24 * 60 * 60) - EVENT_DURATION )
+    for ( group = 0 ; group < group_count ; group++ )
+        if ( get_group_timer(group) > (24 * 60 * 60) - EVENT_DURATION )
             count++;
 
     /* If the number of items is ever zero, the section will be deleted. */
-    return ( active == true ) ? count : (EVENT_COUNT - count);
+    return ( active == true ) ? count : (group_count - count);
+}
+
+/* Return the number of events sharing a row. */
+uint8_t get_event_group_size( const bool active, const uint8_t index ){
+    return get_group_size(get_group(active, index));
+}
+
+/* Return the info struct for one of the events sharing a row. */
+const struct event *get_event_group_info( const bool active, const uint8_t index,
+                                          const uint8_t member ){
+    return &event_info[group_starts[get_group(active, index)] + member];
 }
 
-/* Return the info struct for a event. */
-const struct event *get_event_info( const bool active, const uint8_t index ){
-    return &event_info[get_event_index(active, index)];
+/* Return the local start time of an event in minutes past midnight. */
+uint16_t get_event_start( const struct event *event ){
+    return event_starts[event - event_info];
 }
 
-/* Return the timer for a event. */
+/* Return the timer for a row. */
 uint32_t get_event_timer( const uint8_t index ){
-    return event_times[get_event_index(false, index)];
+    return get_group_timer(get_group(false, index));
 }
 
-/* Return the reminder status. */
+/* Return the reminder status of a row. Like toggle_event_reminder(), this
+ * goes by the whole row, so it's set if any of the row's events are. */
 bool get_event_reminder( const bool active, const uint8_t index ){
-    return event_reminders[get_event_index(active, index)];
+    return get_group_reminder(get_group(active, index));
+}
+
+/*****************************************************************************/
+
+/* Return the first upcoming row with a timer of at least the given value,
+ * or the upcoming event count if every event is sooner than that. The timers
+ * of upcoming rows are always sorted, so we can just binary search them. */
+uint8_t find_event_by_timer( const uint32_t timer ){
+    uint8_t first = get_first_group();
+    uint8_t low = 0;
+    uint8_t high = get_event_count(false);
+
+    while ( low < high ){
+        uint8_t mid = low + ((high - low) / 2);
+        if ( get_group_timer((first + mid) % group_count) < timer )
+            low = mid + 1;
+        else
+            high = mid;
+    }
+
+    return low;
+}
+
+/* Return the first upcoming row at or after the given row that has a
+ * reminder set, or the upcoming event count if there aren't any. */
+uint8_t find_event_reminder( const uint8_t index ){
+    uint8_t first = get_first_group();
+    uint8_t count = get_event_count(false);
+    uint8_t row = index;
+
+    for ( row = index ; row < count ; row++ )
+        if ( get_group_reminder((first + row) % group_count) == true )
+            break;
+
+    return row;
 }
 
 /*****************************************************************************/
 
 /* Save reminders to persistent storage. */
 void save_event_reminders( void ){
+    /* Don't wear out the flash if nothing changed. */
+    if ( event_reminders_unsaved == false )
+        return;
+
     if ( persist_write_int(PERSIST_KEY_DATA_VERSION, EVENT_DATA_VERSION) < S_SUCCESS ||
          persist_write_data(PERSIST_KEY_REMINDERS, event_reminders,
                             sizeof(event_reminders)) != sizeof(event_reminders) )
         APP_LOG(APP_LOG_LEVEL_ERROR, "Error writing reminders to storage.");
-    else
+    else {
         APP_LOG(APP_LOG_LEVEL_INFO, "Saved reminders to storage.");
+        event_reminders_unsaved = false;
+    }
 }
 
 /* Load reminders from persistent storage. */
@@ -123,10 +288,64 @@ void load_event_reminders( void ){
     APP_LOG(APP_LOG_LEVEL_INFO, "Loaded reminders from storage.");
 }
 
-/* Toggle the reminder state of a event. */
+/* Toggle the reminder state of a row. If it has several events, they
+ * all get set, unless some of them already are, then they all get cleared. */
 void toggle_event_reminder( const bool active, const uint8_t index ){
-    uint8_t event = get_event_index(active, index);
-    event_reminders[event] = !event_reminders[event];
+    uint8_t group = get_group(active, index);
+    bool reminder = !get_group_reminder(group);
+
+    memset(&event_reminders[group_starts[group]], reminder,
+           get_group_size(group) * sizeof(event_reminders[0]));
+    state_notify(STATE_REMINDERS);
+}
+
+/*****************************************************************************/
+
+/* Send the reminder list to the phone as a bitset, so it can schedule the
+ * alerts itself. This only sends anything if the list changed since the
+ * last send. Returns false if it needs sending but the outbox was busy. */
+bool send_event_reminders( void ){
+    uint8_t bits[(EVENT_COUNT + 7) / 8] = { 0 };
+    DictionaryIterator *iter = NULL;
+    uint8_t index = 0;
+
+    if ( event_reminders_unsent == false )
+        return true;
+
+    for ( index = 0 ; index <= EVENT_INDEX_MAX ; index++ )
+        if ( event_reminders[index] == true )
+            bits[index / 8] |= 1 << (index % 8);
+
+    if ( app_message_outbox_begin(&iter) != APP_MSG_OK )
+        return false;
+
+    dict_write_int32(iter, APPMSG_KEY_DATA_VERSION, EVENT_DATA_VERSION);
+    dict_write_data(iter, APPMSG_KEY_REMINDERS, bits, sizeof(bits));
+
+    if ( app_message_outbox_send() != APP_MSG_OK )
+        return false;
+
+    APP_LOG(APP_LOG_LEVEL_INFO, "Sent reminders to phone.");
+    event_reminders_unsent = false;
+    return true;
+}
+
+/* Flag the reminder list to be sent again, like when a send failed. */
+void set_event_reminders_unsent( void ){
+    event_reminders_unsent = true;
+    event_reminders_synced = false;
+}
+
+/* Note that the phone got the reminder list. If it changed again since
+ * that send, the phone has an old list, so this waits for the next one. */
+void set_event_reminders_synced( void ){
+    if ( event_reminders_unsent == false )
+        event_reminders_synced = true;
+}
+
+/* Returns true if the early alerts should buzz on the watch. */
+static bool get_early_alerts( void ){
+    return !event_reminders_synced;
 }
 
 /*****************************************************************************/
@@ -135,6 +354,7 @@ void toggle_event_reminder( const bool active, const uint8_t index ){
 void update_event_times( const struct tm *time ){
     uint8_t index = 0;
     struct tm event = *time;
+    bool changed = false;
 
     for ( index = 0 ; index <= EVENT_INDEX_MAX ; index++ ){
         event.tm_hour = event_info[index].hour;
@@ -150,20 +370,76 @@ void update_event_times( const struct tm *time ){
         /* Yeah, this should probably use difftime(), but that includes
          * ~3K of extra library code in the binary, and this case isn't
          * likely to trigger any of difftime()'s edge cases anyway. */
-        event_times[index] = bad_difftime(&event, time);
+        uint32_t timer = bad_difftime(&event, time);
 
-        /* Alert for reminders at 10:00, 5:00, and 0:01 before event start. */
+        /* The timer jumps up by a day when the event starts, and
+         * the event ends when it drops out of the active range. */
+        if ( timer > event_times[index] ||
+             (event_times[index] > (24 * 60 * 60) - EVENT_DURATION &&
+              timer <= (24 * 60 * 60) - EVENT_DURATION) )
+            changed = true;
+
+        event_times[index] = timer;
+
+        /* Alert for reminders at the EVENT_ALERT_* times. */
         /* FIXME If the device skips a second and misses one of these
          * times, I'm not sure how to tell, or what to do about it. */
         if ( event_reminders[index] == true ){
-            /* Do a single pulse for upcoming event alerts. */
-            if ( event_times[index] == 600 || event_times[index] == 300 )
-                vibes_short_pulse();
+            /* Do a single pulse for upcoming event alerts, unless
+             * the phone's timeline is already reminding about them. */
+            if ( event_times[index] == EVENT_ALERT_EARLY ||
+                 event_times[index] == EVENT_ALERT_LATE ){
+                if ( get_early_alerts() == true )
+                    vibes_short_pulse();
+            }
             /* Do a double pulse for events that are starting right now. */
-            else if ( event_times[index] == 1 )
+            else if ( event_times[index] == EVENT_ALERT_START )
                 vibes_double_pulse();
         }
     }
+
+    if ( changed == true )
+        state_notify(STATE_EVENTS);
+}
+
+/* Return the number of seconds until the next reminder alert is due, as of
+ * the last update_event_times() call, or 0 if there aren't any reminders. */
+uint32_t get_next_alert_timer( void ){
+    uint32_t alerts[] = { EVENT_ALERT_EARLY, EVENT_ALERT_LATE, EVENT_ALERT_START };
+    uint32_t next = 0;
+    uint8_t index = 0;
+    uint8_t first = ( get_early_alerts() == true ) ? 0 : 2; /* Skip to START. */
+    uint8_t alert = 0;
+
+    for ( index = 0 ; index <= EVENT_INDEX_MAX ; index++ ){
+        if ( event_reminders[index] == false )
+            continue;
+
+        /* The alerts are in descending order, so the first one
+         * we haven't reached yet is the soonest for this event. */
+        for ( alert = first ; alert < sizeof(alerts) / sizeof(alerts[0]) ; alert++ ){
+            if ( event_times[index] > alerts[alert] ){
+                if ( next == 0 || event_times[index] - alerts[alert] < next )
+                    next = event_times[index] - alerts[alert];
+                break;
+            }
+        }
+    }
+
+    return next;
+}
+
+/*****************************************************************************/
+
+/* Log the size of all the event tables. */
+void report_event_memory( void ){
+    APP_LOG(APP_LOG_LEVEL_INFO, "event_info: %d bytes (+ strings)", (int)sizeof(event_info));
+    APP_LOG(APP_LOG_LEVEL_INFO, "event_times: %d bytes", (int)sizeof(event_times));
+    APP_LOG(APP_LOG_LEVEL_INFO, "event_reminders: %d bytes", (int)sizeof(event_reminders));
+    APP_LOG(APP_LOG_LEVEL_INFO, "event_starts: %d bytes", (int)sizeof(event_starts));
+    APP_LOG(APP_LOG_LEVEL_INFO, "group_starts: %d bytes", (int)sizeof(group_starts));
+    APP_LOG(APP_LOG_LEVEL_INFO, "Event tables: %d of %d bytes budget.",
+            (int)EVENT_MEMORY_SIZE, MEMORY_BUDGET_EVENTS);
 }
 
 /*****************************************************************************/
@@ -175,6 +451,7 @@ void update_event_times( const struct tm *time ){
  * complicated set of lookup tales, not to mention designing a format where
  * the data could fit in limited persistent storage chunks would be tricky. */
 /* XXX Don't forget to update EVENT_INDEX_MAX above! */
+/* XXX Don't forget to update EVENT_INFO in pebble-js-app.js too! */
 /* XXX Keeping this in ascending time order is IMPORTANT! */
 static const struct event event_info[EVENT_COUNT] = {
     { 0,  0, "Taidha Covington", "Bloodtide Coast"},
@@ -27,15 +27,45 @@
 /*****************************************************************************/
 
 /* AppMessage keys. */
-#define APPMSG_KEY_TZ_OFFSET 0
+#define APPMSG_KEY_TZ_OFFSET    0 /* int32_t */
+#define APPMSG_KEY_REMINDERS    1 /* Bitset of (EVENT_COUNT) bits */
+#define APPMSG_KEY_DATA_VERSION 2 /* int32_t */
 
 /* Persistent storage keys. */
 #define PERSIST_KEY_TZ_OFFSET    0 /* int32_t bytes */
 #define PERSIST_KEY_DATA_VERSION 1 /* int32_t bytes */
 #define PERSIST_KEY_REMINDERS    2 /* (bool * EVENT_COUNT) bytes */
 
+/* Use short single-line rows, so more events fit on the screen. */
+#define LAYOUT_DENSE_ROWS false
+
+/* Merge events that start at the same time into a single row. */
+#define MENU_GROUP_EVENTS false
+
+/* State changes, see state.c. */
+#define STATE_TZ_OFFSET   (uint8_t)(1 << 0) /* The time zone offset changed. */
+#define STATE_CLOCK_STYLE (uint8_t)(1 << 1) /* 12/24-hour style changed. */
+#define STATE_REMINDERS   (uint8_t)(1 << 2) /* A reminder was toggled. */
+#define STATE_EVENTS      (uint8_t)(1 << 3) /* An event started or ended. */
+#define STATE_DAY         (uint8_t)(1 << 4) /* The local day rolled over. */
+#define STATE_FOCUS       (uint8_t)(1 << 5) /* The app was covered or uncovered. */
+
+/* Memory pool, see memory.c. It has one block for each buffer that lives
+ * in it, so it can't run out. Those are:
+ *   - The menu's row strings, while a row is being drawn. */
+#define MEMORY_POOL_BLOCK_SIZE 24
+#define MEMORY_POOL_BLOCKS 1
+
+/* Most static memory the event tables may use, not counting strings. */
+#define MEMORY_BUDGET_EVENTS 4096
+
+/* Break the build if a condition isn't true. */
+#define BUILD_ASSERT(cond, name) typedef char build_assert_##name[( cond ) ? 1 : -1]
+
 /*****************************************************************************/
 
+typedef void (*StateChangeHandler)( const uint8_t changes, void *context );
+
 struct event {
     const uint8_t hour;
     const uint8_t min;
@@ -43,22 +73,82 @@ struct event {
     const char *zone;
 };
 
+/* Frames that don't change for a given screen size, see layout.c. */
+struct layout {
+    bool dense;
+    int16_t width;
+    int16_t header_height;
+    int16_t cell_height;
+    int16_t reminder_width;
+
+    GRect header_box;
+    GRect header_text;
+    GRect reminder_box;
+    GRect reminder_bar;
+    GRect reminder_dot;
+    GRect timer_box;
+    GRect timer_text;
+    GRect start_text;
+    GRect name_text;
+    GRect zone_text;
+    GRect tz_message;
+};
+
 /*****************************************************************************/
 
 /* menu.c */
 MenuLayer *event_menu_layer_create( const GRect bounds );
+void event_menu_layer_destroy( MenuLayer *layer );
+void event_menu_set_click_config_onto_window( MenuLayer *layer, Window *window );
 
 /* event.c */
+void set_event_grouping( const bool grouped );
+void subscribe_event_state( void );
+
 uint8_t get_event_count( const bool active );
-const struct event *get_event_info( const bool active, const uint8_t index );
+uint8_t get_event_group_size( const bool active, const uint8_t index );
+const struct event *get_event_group_info( const bool active, const uint8_t index,
+                                          const uint8_t member );
+uint16_t get_event_start( const struct event *event );
 uint32_t get_event_timer( const uint8_t index );
 bool get_event_reminder( const bool active, const uint8_t index );
 
+uint8_t find_event_by_timer( const uint32_t timer );
+uint8_t find_event_reminder( const uint8_t index );
+
 void save_event_reminders( void );
 void load_event_reminders( void );
 void toggle_event_reminder( const bool active, const uint8_t index );
 
+bool send_event_reminders( void );
+void set_event_reminders_unsent( void );
+void set_event_reminders_synced( void );
+
 void update_event_times( const struct tm *time );
+uint32_t get_next_alert_timer( void );
+
+void report_event_memory( void );
+
+/* layout.c */
+void layout_init( const GRect bounds, const bool dense );
+const struct layout *get_layout( void );
+
+/* memory.c */
+void *memory_pool_alloc( const size_t size );
+void memory_pool_free( void *block );
+
+void memory_sample( void );
+void memory_report( void );
+size_t get_memory_heap_peak( void );
+uint8_t get_memory_pool_peak( void );
+
+/* state.c */
+void state_subscribe( const uint8_t changes, const StateChangeHandler handler, void *context );
+void state_unsubscribe( const StateChangeHandler handler );
+void state_notify( const uint8_t changes );
+void state_set_focus( const bool focus );
+bool state_in_focus( void );
+void state_check( const struct tm *time );
 
 /* time.c */
 time_t bad_difftime( const struct tm *time1, const struct tm *time2 );
@@ -69,4 +159,8 @@ bool have_tz_offset( void );
 bool time_convert_utc_to_local( struct tm *time );
 bool time_convert_local_to_utc( struct tm *time );
 
+uint8_t format_timer( char *buffer, const uint32_t time );
+uint8_t format_clock( char *buffer, const uint8_t hour, const uint8_t min,
+                      const bool is_24h );
+
 #endif /* #ifndef _GW2BOSSES_H */
@@ -1,6 +1,312 @@
+/* This must match EVENT_DATA_VERSION and event_info[] in event.c, since the
+ * watch only sends a bitset of reminder indexes into that table. */
+var EVENT_DATA_VERSION = 201406171;
+var EVENT_INFO = [ /* [UTC hour, UTC minute, name, zone] */
+    [ 0,  0, "Taidha Covington", "Bloodtide Coast"],
+    [ 0,  0, "Tequatl the Sunless", "Sparkfly Fen"],
+    [ 0, 15, "Svanir Shaman", "Wayfarer Foothills"],
+    [ 0, 30, "Megadestroyer", "Mount Maelstrom"],
+    [ 0, 45, "Fire Elemental", "Metrica Province"],
+
+    [ 1,  0, "The Shatterer", "Blazeridge Steppes"],
+    [ 1,  0, "Triple Trouble", "Bloodtide Coast"],
+    [ 1, 15, "Great Jungle Wurm", "Caledon Forest"],
+    [ 1, 30, "Modniir Ulgoth", "Hirathi Hinterlands"],
+    [ 1, 45, "Shadow Behemoth", "Queensdale"],
+
+    [ 2,  0, "Golem Mark II", "Mount Maelstrom"],
+    [ 2,  0, "Karka Queen", "Southsun Cove"],
+    [ 2, 15, "Svanir Shaman", "Wayfarer Foothills"],
+    [ 2, 30, "Claw of Jormag", "Frostgorge Sound"],
+    [ 2, 45, "Fire Elemental", "Metrica Province"],
+
+    [ 3,  0, "Taidha Covington", "Bloodtide Coast"],
+    [ 3,  0, "Tequatl the Sunless", "Sparkfly Fen"],
+    [ 3, 15, "Great Jungle Wurm", "Caledon Forest"],
+    [ 3, 30, "Megadestroyer", "Mount Maelstrom"],
+    [ 3, 45, "Shadow Behemoth", "Queensdale"],
+
+    [ 4,  0, "The Shatterer", "Blazeridge Steppes"],
+    [ 4,  0, "Triple Trouble", "Bloodtide Coast"],
+    [ 4, 15, "Svanir Shaman", "Wayfarer Foothills"],
+    [ 4, 30, "Modniir Ulgoth", "Hirathi Hinterlands"],
+    [ 4, 45, "Fire Elemental", "Metrica Province"],
+
+    [ 5,  0, "Golem Mark II", "Mount Maelstrom"],
+    [ 5, 15, "Great Jungle Wurm", "Caledon Forest"],
+    [ 5, 30, "Claw of Jormag", "Frostgorge Sound"],
+    [ 5, 45, "Shadow Behemoth", "Queensdale"],
+
+    [ 6,  0, "Taidha Covington", "Bloodtide Coast"],
+    [ 6,  0, "Karka Queen", "Southsun Cove"],
+    [ 6, 15, "Svanir Shaman", "Wayfarer Foothills"],
+    [ 6, 30, "Megadestroyer", "Mount Maelstrom"],
+    [ 6, 45, "Fire Elemental", "Metrica Province"],
+
+    [ 7,  0, "The Shatterer", "Blazeridge Steppes"],
+    [ 7,  0, "Tequatl the Sunless", "Sparkfly Fen"],
+    [ 7, 15, "Great Jungle Wurm", "Caledon Forest"],
+    [ 7, 30, "Modniir Ulgoth", "Hirathi Hinterlands"],
+    [ 7, 45, "Shadow Behemoth", "Queensdale"],
+
+    [ 8,  0, "Golem Mark II", "Mount Maelstrom"],
+    [ 8,  0, "Triple Trouble", "Bloodtide Coast"],
+    [ 8, 15, "Svanir Shaman", "Wayfarer Foothills"],
+    [ 8, 30, "Claw of Jormag", "Frostgorge Sound"],
+    [ 8, 45, "Fire Elemental", "Metrica Province"],
+
+    [ 9,  0, "Taidha Covington", "Bloodtide Coast"],
+    [ 9, 15, "Great Jungle Wurm", "Caledon Forest"],
+    [ 9, 30, "Megadestroyer", "Mount Maelstrom"],
+    [ 9, 45, "Shadow Behemoth", "Queensdale"],
+
+    [10,  0, "The Shatterer", "Blazeridge Steppes"],
+    [10, 15, "Svanir Shaman", "Wayfarer Foothills"],
+    [10, 30, "Modniir Ulgoth", "Hirathi Hinterlands"],
+    [10, 30, "Karka Queen", "Southsun Cove"],
+    [10, 45, "Fire Elemental", "Metrica Province"],
+
+    [11,  0, "Golem Mark II", "Mount Maelstrom"],
+    [11, 15, "Great Jungle Wurm", "Caledon Forest"],
+    [11, 30, "Claw of Jormag", "Frostgorge Sound"],
+    [11, 30, "Tequatl the Sunless", "Sparkfly Fen"],
+    [11, 45, "Shadow Behemoth", "Queensdale"],
+
+    [12,  0, "Taidha Covington", "Bloodtide Coast"],
+    [12, 15, "Svanir Shaman", "Wayfarer Foothills"],
+    [12, 30, "Megadestroyer", "Mount Maelstrom"],
+    [12, 30, "Triple Trouble", "Bloodtide Coast"],
+    [12, 45, "Fire Elemental", "Metrica Province"],
+
+    [13,  0, "The Shatterer", "Blazeridge Steppes"],
+    [13, 15, "Great Jungle Wurm", "Caledon Forest"],
+    [13, 30, "Modniir Ulgoth", "Hirathi Hinterlands"],
+    [13, 45, "Shadow Behemoth", "Queensdale"],
+
+    [14,  0, "Golem Mark II", "Mount Maelstrom"],
+    [14, 15, "Svanir Shaman", "Wayfarer Foothills"],
+    [14, 30, "Claw of Jormag", "Frostgorge Sound"],
+    [14, 45, "Fire Elemental", "Metrica Province"],
+
+    [15,  0, "Taidha Covington", "Bloodtide Coast"],
+    [15,  0, "Karka Queen", "Southsun Cove"],
+    [15, 15, "Great Jungle Wurm", "Caledon Forest"],
+    [15, 30, "Megadestroyer", "Mount Maelstrom"],
+    [15, 45, "Shadow Behemoth", "Queensdale"],
+
+    [16,  0, "The Shatterer", "Blazeridge Steppes"],
+    [16,  0, "Tequatl the Sunless", "Sparkfly Fen"],
+    [16, 15, "Svanir Shaman", "Wayfarer Foothills"],
+    [16, 30, "Modniir Ulgoth", "Hirathi Hinterlands"],
+    [16, 45, "Fire Elemental", "Metrica Province"],
+
+    [17,  0, "Golem Mark II", "Mount Maelstrom"],
+    [17,  0, "Triple Trouble", "Bloodtide Coast"],
+    [17, 15, "Great Jungle Wurm", "Caledon Forest"],
+    [17, 30, "Claw of Jormag", "Frostgorge Sound"],
+    [17, 45, "Shadow Behemoth", "Queensdale"],
+
+    [18,  0, "Taidha Covington", "Bloodtide Coast"],
+    [18,  0, "Karka Queen", "Southsun Cove"],
+    [18, 15, "Svanir Shaman", "Wayfarer Foothills"],
+    [18, 30, "Megadestroyer", "Mount Maelstrom"],
+    [18, 45, "Fire Elemental", "Metrica Province"],
+
+    [19,  0, "The Shatterer", "Blazeridge Steppes"],
+    [19,  0, "Tequatl the Sunless", "Sparkfly Fen"],
+    [19, 15, "Great Jungle Wurm", "Caledon Forest"],
+    [19, 30, "Modniir Ulgoth", "Hirathi Hinterlands"],
+    [19, 45, "Shadow Behemoth", "Queensdale"],
+
+    [20,  0, "Golem Mark II", "Mount Maelstrom"],
+    [20,  0, "Triple Trouble", "Bloodtide Coast"],
+    [20, 15, "Svanir Shaman", "Wayfarer Foothills"],
+    [20, 30, "Claw of Jormag", "Frostgorge Sound"],
+    [20, 45, "Fire Elemental", "Metrica Province"],
+
+    [21,  0, "Taidha Covington", "Bloodtide Coast"],
+    [21, 15, "Great Jungle Wurm", "Caledon Forest"],
+    [21, 30, "Megadestroyer", "Mount Maelstrom"],
+    [21, 45, "Shadow Behemoth", "Queensdale"],
+
+    [22,  0, "The Shatterer", "Blazeridge Steppes"],
+    [22, 15, "Svanir Shaman", "Wayfarer Foothills"],
+    [22, 30, "Modniir Ulgoth", "Hirathi Hinterlands"],
+    [22, 45, "Fire Elemental", "Metrica Province"],
+
+    [23,  0, "Golem Mark II", "Mount Maelstrom"],
+    [23,  0, "Karka Queen", "Southsun Cove"],
+    [23, 15, "Great Jungle Wurm", "Caledon Forest"],
+    [23, 30, "Claw of Jormag", "Frostgorge Sound"],
+    [23, 45, "Shadow Behemoth", "Queensdale"]
+];
+
+/* Alert at 10 and 5 minutes before the event, like the watch does. */
+var REMINDER_MINUTES = [10, 5];
+
+/* How far ahead to schedule alerts, since each pin is a single event. */
+var SCHEDULE_DAYS = 2;
+
+var TIMELINE_URL = "https://timeline-api.getpebble.com/v1/user/pins/";
+
+/*****************************************************************************/
+
+/* Unpack the reminder bitset from the watch into a list of event indexes. */
+function unpackReminders( bits ){
+    var reminders = [];
+    for ( var index = 0 ; index < EVENT_INFO.length ; index++ )
+        if ( bits[Math.floor(index / 8)] & (1 << (index % 8)) )
+            reminders.push(index);
+    return reminders;
+}
+
+/* Work out every alert for the reminded events from now until the
+ * schedule window runs out. Event times are in UTC, so no tz needed. */
+function scheduleAlerts( reminders, now ){
+    var alerts = [];
+    var today = Date.UTC(now.getUTCFullYear(), now.getUTCMonth(), now.getUTCDate());
+
+    reminders.forEach(function( index ){
+        var event = EVENT_INFO[index];
+        for ( var day = 0 ; day <= SCHEDULE_DAYS ; day++ ){
+            var start = new Date(today + (((((day * 24) + event[0]) * 60) + event[1]) * 60000));
+            if ( start <= now || start - now > SCHEDULE_DAYS * 86400000 )
+                continue;
+            alerts.push({
+                "id": "gw2bosses-" + index + "-" + start.getTime(),
+                "time": start,
+                "name": event[2],
+                "zone": event[3],
+            });
+        }
+    });
+
+    return alerts.sort(function( a, b ){ return a.time - b.time; });
+}
+
+/* Work out which of the pins we pushed before aren't wanted any more.
+ * Pins for events that already started are left alone; they're harmless. */
+function stalePins( pushed, alerts, now ){
+    var wanted = alerts.map(function( alert ){ return alert.id; });
+
+    return pushed.filter(function( id ){
+        return wanted.indexOf(id) < 0 && pinTime(id) > now.getTime();
+    });
+}
+
+/* Get a pin's start time back out of its ID. */
+function pinTime( id ){
+    return Number(id.split("-")[2]);
+}
+
+/* Turn an alert into a timeline pin, with reminders before the start. */
+function alertToPin( alert ){
+    return {
+        "id": alert.id,
+        "time": alert.time.toISOString(),
+        "layout": { "type": "genericPin", "title": alert.name,
+                    "subtitle": alert.zone, "tinyIcon": "system://images/NOTIFICATION_FLAG" },
+        "reminders": REMINDER_MINUTES.map(function( minutes ){
+            return {
+                "time": new Date(alert.time - (minutes * 60000)).toISOString(),
+                "layout": { "type": "genericReminder", "title": alert.name,
+                            "locationName": alert.zone, "tinyIcon": "system://images/NOTIFICATION_FLAG" },
+            };
+        }),
+    };
+}
+
+/* Return the IDs of the pins we know are on the timeline. */
+function loadPushedPins(){
+    return JSON.parse(localStorage.getItem("pins")) || [];
+}
+
+/* Send a single timeline API request for a pin, and call done(true)
+ * if the timeline took it, or done(false) if it didn't. */
+function sendPin( method, token, id, pin, done ){
+    var request = new XMLHttpRequest();
+    request.onload = function(){
+        done(request.status >= 200 && request.status < 300);
+    };
+    request.onerror = function(){
+        done(false);
+    };
+    request.open(method, TIMELINE_URL + id);
+    request.setRequestHeader("Content-Type", "application/json");
+    request.setRequestHeader("X-User-Token", token);
+    request.send(( pin === undefined ) ? null : JSON.stringify(pin));
+}
+
+/* Once we have a timeline token, push the pins that aren't there yet and
+ * delete the ones that aren't wanted any more. The list of pushed pins is
+ * only updated as the timeline confirms each one, so anything that fails
+ * gets another go on the next update. */
+function syncPins( alerts, now ){
+    Pebble.getTimelineToken(function( token ){
+        var pushed = loadPushedPins();
+        var stale = stalePins(pushed, alerts, now);
+        var fresh = alerts.filter(function( alert ){
+            return pushed.indexOf(alert.id) < 0;
+        });
+
+        /* Forget about pins for events that already started. */
+        pushed = pushed.filter(function( id ){
+            return pinTime(id) > now.getTime();
+        });
+        localStorage.setItem("pins", JSON.stringify(pushed));
+
+        fresh.forEach(function( alert ){
+            sendPin("PUT", token, alert.id, alertToPin(alert), function( ok ){
+                if ( ok === false )
+                    return;
+                pushed.push(alert.id);
+                localStorage.setItem("pins", JSON.stringify(pushed));
+            });
+        });
+
+        stale.forEach(function( id ){
+            sendPin("DELETE", token, id, undefined, function( ok ){
+                if ( ok === false )
+                    return;
+                pushed = pushed.filter(function( other ){ return other !== id; });
+                localStorage.setItem("pins", JSON.stringify(pushed));
+            });
+        });
+
+        console.log("Pushing " + fresh.length + " pins to the timeline, " +
+                    "deleting " + stale.length + ".");
+    }, function( error ){
+        console.log("Couldn't get a timeline token: " + error);
+    });
+}
+
+/*****************************************************************************/
+
 Pebble.addEventListener("ready", function( e ){
     var date = new Date();
     var offset = date.getTimezoneOffset();
     console.log("Sending offset " + offset + " to watch.");
     Pebble.sendAppMessage({"tz_offset": offset});
 });
+
+/* The watch sends its reminder list whenever it changes. */
+Pebble.addEventListener("appmessage", function( e ){
+    var bits = e.payload["reminders"];
+    if ( bits === undefined )
+        return;
+
+    if ( e.payload["data_version"] !== EVENT_DATA_VERSION ){
+        console.log("Reminder format mismatch; Discarding.");
+        return;
+    }
+
+    var now = new Date();
+    syncPins(scheduleAlerts(unpackReminders(bits), now), now);
+});
+
+/* Let the scheduling functions be loaded outside the phone for testing. */
+if ( typeof module !== "undefined" )
+    module.exports = { unpackReminders: unpackReminders,
+                       scheduleAlerts: scheduleAlerts,
+                       stalePins: stalePins,
+                       alertToPin: alertToPin };
@@ -0,0 +1,89 @@
+/******************************************************************************
+ *
+ * gw2bosses - A simple Guild Wars 2 boss timer display.
+ *
+ * Copyright 2014 Ryan "BioHazard" Turner <zdbiohazard2@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ *****************************************************************************/
+
+#include "gw2bosses.h"
+
+#define LAYOUT_HEADER_HEIGHT 17
+#define LAYOUT_CELL_HEIGHT 30
+#define LAYOUT_DENSE_CELL_HEIGHT 20
+
+#define LAYOUT_MARGIN 2
+#define LAYOUT_REMINDER_WIDTH 10
+
+#define LAYOUT_MESSAGE_MARGIN 6
+#define LAYOUT_MESSAGE_HEIGHT 44
+
+static struct layout layout;
+
+/*****************************************************************************/
+
+/* Work out every frame we draw from the window bounds, so the draw
+ * callbacks don't have to redo all this arithmetic on every row. */
+void layout_init( const GRect bounds, const bool dense ){
+    int16_t width = bounds.size.w;
+    int16_t cell = ( dense == true ) ? LAYOUT_DENSE_CELL_HEIGHT : LAYOUT_CELL_HEIGHT;
+    int16_t half = cell / 2;
+
+    layout.dense = dense;
+    layout.width = width;
+    layout.header_height = LAYOUT_HEADER_HEIGHT;
+    layout.cell_height = cell;
+
+    /* The header box hangs off the sides so only the top and bottom show. */
+    layout.header_box  = (GRect){{-1, 0}, {width + 2, LAYOUT_HEADER_HEIGHT}};
+    layout.header_text = (GRect){{0, -2}, {width, LAYOUT_HEADER_HEIGHT}};
+
+    /* The reminder marker is an exclamation point in a black box. */
+    layout.reminder_width = LAYOUT_REMINDER_WIDTH;
+    layout.reminder_box = (GRect){{0, 0}, {LAYOUT_REMINDER_WIDTH, cell}};
+    layout.reminder_bar = (GRect){{4, cell / 5}, {2, (cell * 2) / 5}};
+    layout.reminder_dot = (GRect){{4, cell - 8}, {2, 2}};
+
+    /* The timer frames have zero width here, since that depends on the
+     * timer text. The draw code just grows them leftwards to fit. */
+    layout.timer_box  = (GRect){{width, 0}, {0, cell}};
+    if ( dense == true ){
+        layout.timer_text = (GRect){{width - LAYOUT_MARGIN, -4}, {0, cell + 4}};
+        layout.start_text = (GRect){{width - LAYOUT_MARGIN, 0}, {0, 0}};
+    } else {
+        layout.timer_text = (GRect){{width - LAYOUT_MARGIN, -4}, {0, half + 4}};
+        layout.start_text = (GRect){{width - LAYOUT_MARGIN, half - 2}, {0, half + 2}};
+    }
+
+    /* The name frames are full width, minus whatever is on either side. */
+    if ( dense == true ){
+        layout.name_text = (GRect){{LAYOUT_MARGIN, -2}, {width - (LAYOUT_MARGIN * 2), cell}};
+        layout.zone_text = (GRect){{LAYOUT_MARGIN, 0}, {0, 0}};
+    } else {
+        layout.name_text = (GRect){{LAYOUT_MARGIN, -2},
+                                   {width - (LAYOUT_MARGIN * 2), half + 2}};
+        layout.zone_text = (GRect){{LAYOUT_MARGIN, half - 3},
+                                   {width - (LAYOUT_MARGIN * 2), half + 2}};
+    }
+
+    /* Put the time zone message in the middle of the screen. */
+    layout.tz_message = (GRect){{LAYOUT_MESSAGE_MARGIN, (bounds.size.h - LAYOUT_MESSAGE_HEIGHT) / 2},
+                                {width - (LAYOUT_MESSAGE_MARGIN * 2), LAYOUT_MESSAGE_HEIGHT}};
+}
+
+/* Return the precomputed layout. */
+const struct layout *get_layout( void ){
+    return &layout;
+}
@@ -20,24 +20,98 @@
 
 #include "gw2bosses.h"
 
+/* Wait this long before retrying a failed reminder send, doubling each
+ * time it fails again, up to the max. */
+#define REMINDER_RETRY_MIN_MS (uint32_t)1000
+#define REMINDER_RETRY_MAX_MS (uint32_t)(60 * 1000)
+
 static MenuLayer *event_menu = NULL;
 static TextLayer *tz_message = NULL;
 static bool first_tick = true;
+static time_t alert_deadline = 0;
+static time_t timers_updated = 0;
+static AppTimer *reminder_retry = NULL;
+static uint32_t reminder_retry_ms = REMINDER_RETRY_MIN_MS;
 
 /*****************************************************************************/
 
-static void tick_second_handler( struct tm *time, const TimeUnits unit ){
+/* Update the timers from local time. Returns false if we can't yet. */
+static bool update_timers( const struct tm *local ){
     /* Bail out here if the timezone isn't set. */
     if ( have_tz_offset() == false )
-        return;
+        return false;
 
     /* Get the UTC time and update the timers with it. */
-    struct tm utc = *time;
+    struct tm utc = *local;
     time_convert_local_to_utc(&utc);
     update_event_times(&utc);
+    timers_updated = time(NULL);
+    return true;
+}
+
+/* Work out when the next reminder is due, so we can skip the
+ * timer updates until then while something is covering the app.
+ * The timers are only as fresh as the last update, so count from
+ * then; counting from now would land past the exact alert second. */
+static void arm_alert_deadline( void ){
+    uint32_t next = get_next_alert_timer();
+    alert_deadline = ( next == 0 ) ? 0 : timers_updated + next;
+}
+
+/* Returns true once the next reminder is due. */
+static bool alert_deadline_passed( void ){
+    return ( alert_deadline != 0 && time(NULL) >= alert_deadline ) ? true : false;
+}
+
+/*****************************************************************************/
+
+static void send_reminders( void ); /* Defined below. */
+
+static void reminder_retry_fired( void *data ){
+    reminder_retry = NULL;
+    send_reminders();
+}
+
+/* Try sending again later, backing off so a phone that isn't
+ * there doesn't have us waking the radio every second. */
+static void retry_reminders_later( void ){
+    if ( reminder_retry != NULL )
+        return;
+
+    reminder_retry = app_timer_register(reminder_retry_ms, reminder_retry_fired, NULL);
+    reminder_retry_ms = ( reminder_retry_ms * 2 > REMINDER_RETRY_MAX_MS ) ?
+                        REMINDER_RETRY_MAX_MS : reminder_retry_ms * 2;
+}
+
+/* Let the phone know if the reminders changed. */
+static void send_reminders( void ){
+    if ( send_event_reminders() == false )
+        retry_reminders_later();
+}
+
+/*****************************************************************************/
+
+static void tick_second_handler( struct tm *time, const TimeUnits unit ){
+    /* Sample the heap once a second. This only sees what's in use right
+     * now, so anything the menu allocates and frees in between is missed. */
+    memory_sample();
+
+    /* Nobody can see the menu while we're out of focus, so just
+     * wait for the next reminder instead of updating everything. */
+    if ( state_in_focus() == false ){
+        if ( alert_deadline_passed() == true ){
+            update_timers(time);
+            arm_alert_deadline();
+        }
+        return;
+    }
 
-    /* Reload the menu in case row counts change. */
-    menu_layer_reload_data(event_menu);
+    /* Look for clock style changes and such. */
+    state_check(time);
+
+    /* The menu reloads itself if this starts or ends any events. */
+    if ( update_timers(time) == false )
+        return;
 
     /* Stuff to do on the first tick. */
     if ( first_tick == true ){
@@ -56,26 +130,64 @@ static void tick_second_handler( struct tm *time, const TimeUnits unit ){
         layer_set_hidden(menu_layer_get_layer(event_menu), false);
 
         first_tick = false;
+
+        /* Everything's been created and drawn once by now. */
+        memory_report();
     }
 
     layer_mark_dirty(menu_layer_get_layer(event_menu));
 }
 
+/* Toggling reminders moves the next alert. The timers count to UTC event
+ * times, so a time zone change can't move any alerts, and re-arming for
+ * one would just risk counting from the wrong second. The event tables
+ * subscribe first, so they've already marked the reminders unsent. */
+static void main_state_changed( const uint8_t changes, void *context ){
+    send_reminders();
+
+    if ( state_in_focus() == false )
+        arm_alert_deadline();
+}
+
+/* Stop updating while notifications and such are covering the app. */
+static void focus_handler( const bool focus ){
+    state_set_focus(focus);
+
+    if ( focus == false ){
+        arm_alert_deadline();
+        return;
+    }
+
+    /* Catch up with everything we skipped in a single update. The menu
+     * already caught up on any row changes when the focus came back. */
+    time_t now = time(NULL);
+    tick_second_handler(localtime(&now), SECOND_UNIT);
+}
+
 /*****************************************************************************/
 
 static void window_load( Window *window ){
     Layer *window_layer = window_get_root_layer(window);
 
+    /* Set up the menu rows before anything asks about them. */
+    set_event_grouping(MENU_GROUP_EVENTS);
+    subscribe_event_state();
+    state_subscribe(STATE_REMINDERS, main_state_changed, NULL);
+
+    /* Work out where everything goes for this screen size. */
+    layout_init(layer_get_bounds(window_layer), LAYOUT_DENSE_ROWS);
+
     /* Create the event menu, and bind it to this window. */
     event_menu = event_menu_layer_create(layer_get_frame(window_layer));
-    menu_layer_set_click_config_onto_window(event_menu, window);
+    event_menu_set_click_config_onto_window(event_menu, window);
     layer_add_child(window_layer, menu_layer_get_layer(event_menu));
     layer_set_hidden(menu_layer_get_layer(event_menu), true);
 
     /* On the first run, the time zone offset must be fetched from the phone.
      * This creates a message box telling the user what's happening. */
     if ( have_tz_offset() == false ){
-        tz_message = text_layer_create((GRect){{6, 52}, {132, 44}});
+        tz_message = text_layer_create(get_layout()->tz_message);
+        memory_sample();
         text_layer_set_text(tz_message, "Getting time zone from your phone");
         text_layer_set_background_color(tz_message, GColorBlack);
         text_layer_set_text_alignment(tz_message, GTextAlignmentCenter);
@@ -85,24 +197,51 @@ static void window_load( Window *window ){
     }
 
     load_event_reminders();
+    send_reminders();
 
     tick_timer_service_subscribe(SECOND_UNIT, tick_second_handler);
+    app_focus_service_subscribe(focus_handler);
+
+    memory_sample();
 }
 
 static void window_unload( Window *window ){
+    app_focus_service_unsubscribe();
+    memory_report();
     save_event_reminders();
 
+    /* Get any last changes to the phone, if it'll take them right now. */
+    send_event_reminders();
+    if ( reminder_retry != NULL )
+        app_timer_cancel(reminder_retry);
+    reminder_retry = NULL;
+
     if ( tz_message != NULL )
         text_layer_destroy(tz_message);
-    menu_layer_destroy(event_menu);
+    event_menu_layer_destroy(event_menu);
 }
 
 /*****************************************************************************/
 
+/* If the reminders are waiting on a retry, skip the rest of the
+ * backoff and send them now that we know the phone is there. */
+static void retry_failed_send( void ){
+    if ( reminder_retry == NULL )
+        return;
+
+    app_timer_cancel(reminder_retry);
+    reminder_retry = NULL;
+    reminder_retry_ms = REMINDER_RETRY_MIN_MS;
+    send_reminders();
+}
+
 /* Receive time zone information from the phone. */
 static void in_received_handler( DictionaryIterator *data, void *context ){
     Tuple *tuple = dict_find(data, APPMSG_KEY_TZ_OFFSET);
 
+    /* The phone is talking to us, so it should be listening too. */
+    retry_failed_send();
+
     /* Just bail here if this isn't the right type of data. */
     if ( tuple == NULL || tuple->type != TUPLE_INT )
         return;
@@ -118,16 +257,41 @@ static void in_dropped_handler( const AppMessageResult reason, void *context ){
     APP_LOG(APP_LOG_LEVEL_ERROR, "An AppMessage was dropped: %d", reason);
 }
 
+/* The phone has the reminders, so its timeline takes over the early
+ * alerts, and the next failure starts a fresh backoff. */
+static void out_sent_handler( DictionaryIterator *data, void *context ){
+    set_event_reminders_synced();
+    reminder_retry_ms = REMINDER_RETRY_MIN_MS;
+}
+
+/* The reminders are the only thing we send, so send them again later. */
+static void out_failed_handler( DictionaryIterator *data, const AppMessageResult reason, void *context ){
+    APP_LOG(APP_LOG_LEVEL_ERROR, "An AppMessage failed to send: %d", reason);
+    set_event_reminders_unsent();
+    retry_reminders_later();
+}
+
+/* Try sending again when the phone comes back. */
+static void bluetooth_handler( const bool connected ){
+    if ( connected == true )
+        retry_failed_send();
+}
+
 /*****************************************************************************/
 
 int main( void ){
-    /* Set-up the app messaging system so we can get an updated time zone. */
+    /* Set-up the app messaging system so we can get an updated
+     * time zone, and send the reminder list to the phone. */
     app_message_register_inbox_received(in_received_handler);
     app_message_register_inbox_dropped(in_dropped_handler);
-    app_message_open(16, 16);
+    app_message_register_outbox_sent(out_sent_handler);
+    app_message_register_outbox_failed(out_failed_handler);
+    app_message_open(16, 64);
+    bluetooth_connection_service_subscribe(bluetooth_handler);
 
     /* Create the main window. */
     Window *window = window_create();
+    memory_sample();
     window_set_window_handlers(window, (WindowHandlers){
         .load = window_load,
         .unload = window_unload,
@@ -0,0 +1,108 @@
+/******************************************************************************
+ *
+ * gw2bosses - A simple Guild Wars 2 boss timer display.
+ *
+ * Copyright 2014 Ryan "BioHazard" Turner <zdbiohazard2@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ *****************************************************************************/
+
+#include "gw2bosses.h"
+
+/* Fixed-size blocks for buffers that outlive a single call, so they have
+ * a known size at build time instead of coming out of the app heap. The
+ * sizes are in gw2bosses.h, along with the list of who uses them. */
+BUILD_ASSERT(MEMORY_POOL_BLOCKS <= 8, pool_used_fits_in_a_byte);
+
+static uint8_t memory_pool[MEMORY_POOL_BLOCKS][MEMORY_POOL_BLOCK_SIZE];
+static uint8_t memory_pool_used = 0; /* One bit per block. */
+static uint8_t memory_pool_count = 0;
+static uint8_t memory_pool_peak = 0;
+
+static size_t memory_heap_peak = 0;
+
+/*****************************************************************************/
+
+/* Grab a pool block. Returns NULL if it won't fit or we're all out. */
+void *memory_pool_alloc( const size_t size ){
+    uint8_t index = 0;
+
+    if ( size > MEMORY_POOL_BLOCK_SIZE ){
+        APP_LOG(APP_LOG_LEVEL_ERROR, "Pool block too small for %d bytes.", (int)size);
+        return NULL;
+    }
+
+    for ( index = 0 ; index < MEMORY_POOL_BLOCKS ; index++ )
+        if ( (memory_pool_used & (1 << index)) == 0 )
+            break;
+
+    if ( index == MEMORY_POOL_BLOCKS ){
+        APP_LOG(APP_LOG_LEVEL_ERROR, "Out of pool blocks.");
+        return NULL;
+    }
+
+    memory_pool_used |= 1 << index;
+
+    /* Keep track of the most blocks we've ever had out at once. */
+    if ( ++memory_pool_count > memory_pool_peak )
+        memory_pool_peak = memory_pool_count;
+
+    return memory_pool[index];
+}
+
+/* Give a pool block back. */
+void memory_pool_free( void *block ){
+    uint8_t index = 0;
+
+    for ( index = 0 ; index < MEMORY_POOL_BLOCKS ; index++ )
+        if ( block == memory_pool[index] && (memory_pool_used & (1 << index)) != 0 ){
+            memory_pool_used &= ~(1 << index);
+            memory_pool_count--;
+        }
+}
+
+/*****************************************************************************/
+
+/* There's no way to ask for the heap high-water mark, so we keep the
+ * highest usage we've seen instead. Call this after anything that uses the
+ * heap, and on every tick. It only sees what's in use when it's called, so
+ * this peak can be lower than the real one. */
+void memory_sample( void ){
+    size_t used = heap_bytes_used();
+
+    if ( used > memory_heap_peak )
+        memory_heap_peak = used;
+}
+
+/* Log everything we know about how much memory we're using. */
+void memory_report( void ){
+    memory_sample();
+
+    APP_LOG(APP_LOG_LEVEL_INFO, "Heap: %d used, %d free, %d peak.",
+            (int)heap_bytes_used(), (int)heap_bytes_free(), (int)memory_heap_peak);
+    APP_LOG(APP_LOG_LEVEL_INFO, "Pool: %d of %d blocks of %d bytes peak.",
+            memory_pool_peak, MEMORY_POOL_BLOCKS, MEMORY_POOL_BLOCK_SIZE);
+
+    report_event_memory();
+}
+
+/* Return the most heap we've seen in use. */
+size_t get_memory_heap_peak( void ){
+    return memory_heap_peak;
+}
+
+/* Return the most pool blocks that were ever out at once. */
+uint8_t get_memory_pool_peak( void ){
+    return memory_pool_peak;
+}
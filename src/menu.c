@@ -20,21 +20,33 @@
 
 #include "gw2bosses.h"
 
-#define MENU_HEADER_HEIGHT 17
-#define MENU_CELL_HEIGHT 30
-
 #define MENU_SECTION_COUNT 2
 #define MENU_SECTION_CURRENT 0
 #define MENU_SECTION_COMINGUP 1
 
+#define MENU_GROUP_CYCLE_SECS 2
+
+/* Space for the strings in a row. This comes from the memory pool while
+ * the row is being drawn, and goes back as soon as it's done. */
+struct menu_row_text {
+    char timer[9];
+    char start[9];
+};
+BUILD_ASSERT(sizeof(struct menu_row_text) <= MEMORY_POOL_BLOCK_SIZE, menu_row_text_fits);
+
+#define MENU_SCROLL_REPEAT_MS 100
+#define MENU_JUMP_LONG_MS 500
+
+static bool menu_reload_pending = false;
+
 /*****************************************************************************/
 
 static int16_t menu_get_header_height( MenuLayer *layer, const uint16_t index, void *data ){
-    return MENU_HEADER_HEIGHT;
+    return get_layout()->header_height;
 }
 
 static int16_t menu_get_cell_height( MenuLayer *layer, MenuIndex *index, void *data ){
-    return MENU_CELL_HEIGHT;
+    return get_layout()->cell_height;
 }
 
 /*****************************************************************************/
@@ -49,85 +61,98 @@ static uint16_t menu_get_num_rows( MenuLayer *layer, const uint16_t index, void
 
 /*****************************************************************************/
 
+/* Grow a right-aligned frame leftwards to the given width. */
+static GRect menu_grow_left( GRect rect, const int16_t width ){
+    rect.origin.x -= width;
+    rect.size.w = width;
+    return rect;
+}
+
+/* Shrink a left-aligned frame to make room on either side. */
+static GRect menu_shrink( GRect rect, const int16_t left, const int16_t right ){
+    rect.origin.x += left;
+    rect.size.w -= left + right;
+    return rect;
+}
+
+/*****************************************************************************/
+
 /* Just draw a basic header. */
 static void menu_draw_header( GContext *ctx, const Layer *cell, const uint16_t index, void *data ){
     char *titles[MENU_SECTION_COUNT] = { "Happening Now", "Coming Up" };
+    const struct layout *layout = get_layout();
 
     graphics_context_set_stroke_color(ctx, GColorBlack);
     graphics_context_set_text_color(ctx, GColorBlack);
 
-    graphics_draw_rect(ctx, (GRect){{-1, 0}, {146, MENU_HEADER_HEIGHT}});
+    graphics_draw_rect(ctx, layout->header_box);
     graphics_draw_text(ctx, titles[index], fonts_get_system_font(FONT_KEY_GOTHIC_14_BOLD),
-                       (GRect){{0, -2}, {144, MENU_HEADER_HEIGHT}},
+                       layout->header_text,
                        GTextOverflowModeTrailingEllipsis, GTextAlignmentCenter, NULL);
 }
 
 /* Draw individual rows. */
 static void menu_draw_row( GContext *ctx, const Layer *layer, MenuIndex *cell, void *data ){
-    const struct event *event = get_event_info(!cell->section, cell->row);
+    uint8_t members = get_event_group_size(!cell->section, cell->row);
+    const struct layout *layout = get_layout();
+
+    /* Rows with several simultaneous events take turns showing each one. */
+    uint8_t member = ( members > 1 ) ? (time(NULL) / MENU_GROUP_CYCLE_SECS) % members : 0;
+    const struct event *event = get_event_group_info(!cell->section, cell->row, member);
     uint8_t offset = 0;
     uint8_t width = 0;
+    struct menu_row_text *text = NULL;
 
     /* Skip the timer on the current entries. */
     /* TODO Display an uptime counter for the current event. */
-    if ( cell->section == MENU_SECTION_COMINGUP ){
+    if ( cell->section == MENU_SECTION_COMINGUP )
+        text = memory_pool_alloc(sizeof(struct menu_row_text));
+
+    /* The pool has a block set aside for this, but if it's ever
+     * missing, the row still gets drawn, just without the timer. */
+    if ( text != NULL ){
         uint8_t timer_width[] = { 0, 12, 20, 24, 32, 40, 44, 52, 60 };
         uint8_t start_width[] = { 0, 10, 16, 20, 26, 32, 42, 44, 50 };
         uint32_t time = get_event_timer(cell->row);
-        char timer[9] = { 0 };
-        char start[9] = { 0 };
-
-        /* Create the time string. Use a different formula for > 1hr times. */
-        if ( time >= 3600 )
-            snprintf(timer, sizeof(timer), "%"PRIu32":%02"PRIu32":%02"PRIu32,
-                     time / 3600, (time / 60) % 60, time % 60);
-        else
-            snprintf(timer, sizeof(timer), "%"PRIu32":%02"PRIu32,
-                     time / 60, time % 60);
-
-        /* We need a representation of the event start time, so make one.
-         * It also needs to be adjusted for the current time zone. Argh. :S */
-        /* FIXME Someday, Pebble might have a working timezone system. :( */
-        struct tm event_tm = { 0 };
-        event_tm.tm_year = 112; /* bad_mktime() has issues with 1900. ;) */
-        event_tm.tm_hour = event->hour;
-        event_tm.tm_min  = event->min;
-        time_convert_utc_to_local(&event_tm);
-
-        /* Create the event start timer. */
-        if ( clock_is_24h_style() == true )
-            snprintf(start, sizeof(start), "@%02d:%02d",
-                     event_tm.tm_hour, event_tm.tm_min);
-        else /* Silly 12-hour format. :p */
-            snprintf(start, sizeof(start), "%d:%02d %s",
-                     ( event_tm.tm_hour == 0 ) ? 12 : event_tm.tm_hour % 12,
-                     event_tm.tm_min, ( event_tm.tm_hour < 12 ) ? "AM" : "PM");
+        char *timer = text->timer;
+        char *start = text->start;
+        uint8_t timer_len = format_timer(timer, time);
+        uint8_t start_len = 0;
+
+        start[0] = '\0';
+
+        /* Dense rows don't have room for the start time. */
+        if ( layout->dense == false ){
+            uint16_t minutes = get_event_start(event);
+            start_len = format_clock(start, minutes / 60, minutes % 60,
+                                     clock_is_24h_style());
+        }
 
         /* Set the box widths based on time string lengths. I tried using
          * graphics_text_layout_get_content_size() for this, but it seemed
          * to make scrolling slower, so we're using lookup tableis instead. */
-        width = ( timer_width[strlen(timer)] > start_width[strlen(start)] ) ?
-                  timer_width[strlen(timer)] : start_width[strlen(start)];
+        width = ( timer_width[timer_len] > start_width[start_len] ) ?
+                  timer_width[timer_len] : start_width[start_len];
 
         /* Display the timer cell white-on-black. */
         graphics_context_set_fill_color(ctx, GColorBlack);
         graphics_context_set_text_color(ctx, GColorWhite);
 
         /* Fill the timer cell. */
-        graphics_fill_rect(ctx, (GRect){{144 - width, 0},
-                                        {width, MENU_CELL_HEIGHT}}, 0, GCornerNone);
+        graphics_fill_rect(ctx, menu_grow_left(layout->timer_box, width), 0, GCornerNone);
 
         /* Draw the event timer. */
         graphics_draw_text(ctx, timer, fonts_get_system_font(FONT_KEY_GOTHIC_18_BOLD),
-                           (GRect){{142 - width, -4},
-                                   {width, (MENU_CELL_HEIGHT / 2) + 4}},
+                           menu_grow_left(layout->timer_text, width),
                            GTextOverflowModeWordWrap, GTextAlignmentRight, NULL);
 
         /* Draw the event real time. */
-        graphics_draw_text(ctx, start, fonts_get_system_font(FONT_KEY_GOTHIC_14),
-                           (GRect){{142 - width, (MENU_CELL_HEIGHT / 2) - 2},
-                                   {width, (MENU_CELL_HEIGHT / 2) + 2}},
-                           GTextOverflowModeWordWrap, GTextAlignmentRight, NULL);
+        if ( layout->dense == false )
+            graphics_draw_text(ctx, start, fonts_get_system_font(FONT_KEY_GOTHIC_14),
+                               menu_grow_left(layout->start_text, width),
+                               GTextOverflowModeWordWrap, GTextAlignmentRight, NULL);
+
+        memory_pool_free(text);
     }
 
     /* Change the text color back to black for the left cell. */
@@ -136,42 +161,141 @@ static void menu_draw_row( GContext *ctx, const Layer *layer, MenuIndex *cell, v
     /* Draw a reminder icon. */
     if ( get_event_reminder(!cell->section, cell->row) == true ){
         /* Set the text frame offset so we have space to draw. */
-        offset = 10;
+        offset = layout->reminder_width;
 
         /* Draw a black cell. */
         graphics_context_set_fill_color(ctx, GColorBlack);
-        graphics_fill_rect(ctx, (GRect){{0, 0}, {offset, MENU_CELL_HEIGHT}}, 0, GCornerNone);
+        graphics_fill_rect(ctx, layout->reminder_box, 0, GCornerNone);
 
         /* Draw an exclamation point using 2 tiny rectangles. */
         graphics_context_set_stroke_color(ctx, GColorWhite);
-        graphics_draw_rect(ctx, (GRect){{4, 6}, {2, 12}});
-        graphics_draw_rect(ctx, (GRect){{4, 22}, {2, 2}});
+        graphics_draw_rect(ctx, layout->reminder_bar);
+        graphics_draw_rect(ctx, layout->reminder_dot);
     }
 
     /* Draw the event title. */
     graphics_draw_text(ctx, event->name, fonts_get_system_font(FONT_KEY_GOTHIC_14_BOLD),
-                       (GRect){{2 + offset, -2},
-                               {140 - (width + offset), (MENU_CELL_HEIGHT / 2) + 2}},
+                       menu_shrink(layout->name_text, offset, width),
                        GTextOverflowModeTrailingEllipsis, GTextAlignmentLeft, NULL);
 
     /* Draw the event location. */
-    graphics_draw_text(ctx, event->zone, fonts_get_system_font(FONT_KEY_GOTHIC_14),
-                       (GRect){{2 + offset, (MENU_CELL_HEIGHT / 2) - 3},
-                               {140 - (width + offset), (MENU_CELL_HEIGHT / 2) + 2}},
-                       GTextOverflowModeTrailingEllipsis, GTextAlignmentLeft, NULL);
+    if ( layout->dense == false )
+        graphics_draw_text(ctx, event->zone, fonts_get_system_font(FONT_KEY_GOTHIC_14),
+                           menu_shrink(layout->zone_text, offset, width),
+                           GTextOverflowModeTrailingEllipsis, GTextAlignmentLeft, NULL);
 }
 
 /*****************************************************************************/
 
-void menu_select_click( MenuLayer *layer, MenuIndex *cell, void *data ){
+static void menu_select_click( MenuLayer *layer, MenuIndex *cell, void *data ){
     toggle_event_reminder(!cell->section, cell->row);
-    layer_mark_dirty(menu_layer_get_layer(layer));
+}
+
+/* Only reload the rows when the list actually changed. Everything
+ * else just needs a redraw, like the time format or reminder icons. */
+static void menu_state_changed( const uint8_t changes, void *context ){
+    if ( changes & (STATE_TZ_OFFSET | STATE_EVENTS | STATE_DAY) )
+        menu_reload_pending = true;
+
+    /* Row changes pile up while we're covered, and the STATE_FOCUS
+     * notice when we're uncovered does a single reload for all of them. */
+    if ( state_in_focus() == false )
+        return;
+
+    if ( menu_reload_pending == true ){
+        menu_layer_reload_data(context);
+        menu_reload_pending = false;
+    }
+
+    layer_mark_dirty(menu_layer_get_layer(context));
+}
+
+/*****************************************************************************/
+
+/* Return the selected upcoming row, or -1 if a current event is selected. */
+static int16_t menu_get_selected_row( MenuLayer *layer ){
+    MenuIndex index = menu_layer_get_selected_index(layer);
+    return ( index.section == MENU_SECTION_COMINGUP ) ? index.row : -1;
+}
+
+/* Jump straight to an upcoming row. This is a single selection change,
+ * so we only get one redraw instead of one for every row we skip over. */
+static void menu_jump_to_row( MenuLayer *layer, const uint8_t row ){
+    if ( row >= get_event_count(false) )
+        return;
+
+    menu_layer_set_selected_index(layer, (MenuIndex){MENU_SECTION_COMINGUP, row},
+                                  MenuRowAlignCenter, false);
+}
+
+/* Jump to the next upcoming event with a reminder set, wrapping around. */
+static void menu_jump_to_reminder( MenuLayer *layer ){
+    uint8_t row = find_event_reminder(menu_get_selected_row(layer) + 1);
+
+    if ( row >= get_event_count(false) )
+        row = find_event_reminder(0);
+
+    menu_jump_to_row(layer, row);
+}
+
+/* Jump to the first event that starts in the next hour on the clock. */
+static void menu_jump_to_next_hour( MenuLayer *layer ){
+    int16_t row = menu_get_selected_row(layer);
+    uint32_t timer = ( row < 0 ) ? 0 : get_event_timer(row);
+
+    /* Work out how far into the hour the selected event starts. */
+    time_t now = time(NULL);
+    struct tm *local = localtime(&now);
+    uint32_t into_hour = ((local->tm_min * 60) + local->tm_sec + timer) % 3600;
+
+    menu_jump_to_row(layer, find_event_by_timer(timer + (3600 - into_hour)));
+}
+
+/*****************************************************************************/
+
+static void menu_up_click( ClickRecognizerRef recognizer, void *context ){
+    menu_layer_set_selected_next(context, true, MenuRowAlignCenter, true);
+}
+
+static void menu_down_click( ClickRecognizerRef recognizer, void *context ){
+    menu_layer_set_selected_next(context, false, MenuRowAlignCenter, true);
+}
+
+static void menu_select_single_click( ClickRecognizerRef recognizer, void *context ){
+    MenuIndex index = menu_layer_get_selected_index(context);
+    menu_select_click(context, &index, NULL);
+}
+
+static void menu_select_long_click( ClickRecognizerRef recognizer, void *context ){
+    menu_jump_to_reminder(context);
+}
+
+static void menu_select_multi_click( ClickRecognizerRef recognizer, void *context ){
+    menu_jump_to_next_hour(context);
+}
+
+/* This replaces the stock menu click config so we can add jump buttons.
+ * Up and down still scroll normally, since long-presses on those would
+ * get in the way of holding them down to scroll quickly. The catch is that
+ * a single select click now waits out the double-click timeout before it
+ * toggles the reminder. */
+static void menu_click_config_provider( void *context ){
+    window_single_repeating_click_subscribe(BUTTON_ID_UP, MENU_SCROLL_REPEAT_MS, menu_up_click);
+    window_single_repeating_click_subscribe(BUTTON_ID_DOWN, MENU_SCROLL_REPEAT_MS, menu_down_click);
+    window_single_click_subscribe(BUTTON_ID_SELECT, menu_select_single_click);
+    window_long_click_subscribe(BUTTON_ID_SELECT, MENU_JUMP_LONG_MS, menu_select_long_click, NULL);
+    window_multi_click_subscribe(BUTTON_ID_SELECT, 2, 2, 0, true, menu_select_multi_click);
+}
+
+void event_menu_set_click_config_onto_window( MenuLayer *layer, Window *window ){
+    window_set_click_config_provider_with_context(window, menu_click_config_provider, layer);
 }
 
 /*****************************************************************************/
 
 MenuLayer *event_menu_layer_create( const GRect bounds ){
     MenuLayer *menu_layer = menu_layer_create(bounds);
+    memory_sample();
 
     menu_layer_set_callbacks(menu_layer, NULL, (MenuLayerCallbacks){
         .get_header_height = menu_get_header_height,
@@ -180,8 +304,15 @@ MenuLayer *event_menu_layer_create( const GRect bounds ){
         .get_num_rows = menu_get_num_rows,
         .draw_header = menu_draw_header,
         .draw_row = menu_draw_row,
-        .select_click = menu_select_click,
     });
 
+    state_subscribe(STATE_TZ_OFFSET | STATE_CLOCK_STYLE | STATE_REMINDERS |
+                    STATE_EVENTS | STATE_DAY | STATE_FOCUS, menu_state_changed, menu_layer);
+
     return menu_layer;
 }
+
+void event_menu_layer_destroy( MenuLayer *layer ){
+    state_unsubscribe(menu_state_changed);
+    menu_layer_destroy(layer);
+}
@@ -0,0 +1,108 @@
+/******************************************************************************
+ *
+ * gw2bosses - A simple Guild Wars 2 boss timer display.
+ *
+ * Copyright 2014 Ryan "BioHazard" Turner <zdbiohazard2@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ *****************************************************************************/
+
+#include "gw2bosses.h"
+
+#define STATE_HANDLER_MAX 4
+
+struct state_handler {
+    uint8_t changes;
+    StateChangeHandler handler;
+    void *context;
+};
+
+static struct state_handler state_handlers[STATE_HANDLER_MAX];
+static bool state_clock_24h = false;
+static int state_yday = -1;
+static bool state_focus = true;
+
+/*****************************************************************************/
+
+/* Call the handler whenever any of the given changes happen. */
+void state_subscribe( const uint8_t changes, const StateChangeHandler handler, void *context ){
+    uint8_t index = 0;
+
+    for ( index = 0 ; index < STATE_HANDLER_MAX ; index++ ){
+        if ( state_handlers[index].handler == NULL ){
+            state_handlers[index] = (struct state_handler){ changes, handler, context };
+            return;
+        }
+    }
+
+    APP_LOG(APP_LOG_LEVEL_ERROR, "Out of state handler slots.");
+}
+
+/* Stop calling the handler. */
+void state_unsubscribe( const StateChangeHandler handler ){
+    uint8_t index = 0;
+
+    for ( index = 0 ; index < STATE_HANDLER_MAX ; index++ )
+        if ( state_handlers[index].handler == handler )
+            state_handlers[index] = (struct state_handler){ 0, NULL, NULL };
+}
+
+/* Let everyone who cares know that something changed. Handlers only
+ * get told about the changes they subscribed to. */
+void state_notify( const uint8_t changes ){
+    uint8_t index = 0;
+
+    for ( index = 0 ; index < STATE_HANDLER_MAX ; index++ )
+        if ( state_handlers[index].handler != NULL &&
+             (state_handlers[index].changes & changes) != 0 )
+            state_handlers[index].handler(state_handlers[index].changes & changes,
+                                          state_handlers[index].context);
+}
+
+/*****************************************************************************/
+
+/* Note whether the app is visible, and tell anyone who cares. */
+void state_set_focus( const bool focus ){
+    if ( focus == state_focus )
+        return;
+
+    state_focus = focus;
+    state_notify(STATE_FOCUS);
+}
+
+/* Returns false while something is covering the app. */
+bool state_in_focus( void ){
+    return state_focus;
+}
+
+/*****************************************************************************/
+
+/* Check for changes we can only find out about by looking, like the
+ * clock style or the day rolling over. Call this on every tick. */
+void state_check( const struct tm *time ){
+    uint8_t changes = 0;
+
+    if ( clock_is_24h_style() != state_clock_24h ){
+        state_clock_24h = !state_clock_24h;
+        changes |= STATE_CLOCK_STYLE;
+    }
+
+    if ( time->tm_yday != state_yday ){
+        state_yday = time->tm_yday;
+        changes |= STATE_DAY;
+    }
+
+    if ( changes != 0 )
+        state_notify(changes);
+}
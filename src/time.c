@@ -80,6 +80,7 @@ void set_tz_offset( const int32_t offset ){
     /* Write the offset to storage if it's different than what we have. */
     APP_LOG(APP_LOG_LEVEL_INFO, "Writing offset %"PRId32" to storage.", tz_offset);
     persist_write_int(PERSIST_KEY_TZ_OFFSET, tz_offset);
+    state_notify(STATE_TZ_OFFSET);
 }
 
 /* Returns true if get_tz_offset() returns a valid value. */
@@ -110,3 +111,67 @@ bool time_convert_utc_to_local( struct tm *time ){
     memcpy(time, localtime(&local_ts), sizeof(struct tm));
     return true;
 }
+
+/*****************************************************************************/
+
+/* Write a number as two digits, and return the next spot in the buffer. */
+static char *format_two_digits( char *buffer, const uint8_t value ){
+    buffer[0] = '0' + (value / 10);
+    buffer[1] = '0' + (value % 10);
+    return buffer + 2;
+}
+
+/* Write a number without leading zeros, and return the next spot. */
+static char *format_digits( char *buffer, const uint8_t value ){
+    if ( value >= 10 )
+        *buffer++ = '0' + (value / 10);
+    *buffer++ = '0' + (value % 10);
+    return buffer;
+}
+
+/* These are called for every row on every redraw, so they build the strings
+ * by hand instead of using snprintf(). The buffer must hold 9 characters.
+ * They return the string length, so there's no need to strlen() it. */
+
+/* Format a countdown as H:MM:SS, or M:SS for times under an hour. */
+uint8_t format_timer( char *buffer, const uint32_t time ){
+    uint32_t minutes = time / 60;
+    char *end = buffer;
+
+    if ( time >= 3600 ){
+        end = format_digits(end, minutes / 60);
+        *end++ = ':';
+        end = format_two_digits(end, minutes % 60);
+    } else
+        end = format_digits(end, minutes);
+
+    *end++ = ':';
+    end = format_two_digits(end, time % 60);
+    *end = '\0';
+
+    return end - buffer;
+}
+
+/* Format a time of day as @HH:MM, or h:MM AM/PM in 12-hour style. */
+uint8_t format_clock( char *buffer, const uint8_t hour, const uint8_t min,
+                      const bool is_24h ){
+    char *end = buffer;
+
+    if ( is_24h == true ){
+        *end++ = '@';
+        end = format_two_digits(end, hour);
+    } else /* Silly 12-hour format. :p */
+        end = format_digits(end, ( hour % 12 == 0 ) ? 12 : hour % 12);
+
+    *end++ = ':';
+    end = format_two_digits(end, min);
+
+    if ( is_24h == false ){
+        *end++ = ' ';
+        *end++ = ( hour < 12 ) ? 'A' : 'P';
+        *end++ = 'M';
+    }
+    *end = '\0';
+
+    return end - buffer;
+}
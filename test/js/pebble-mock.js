@@ -0,0 +1,61 @@
+/* A stand-in for the PebbleKit JS environment, so pebble-js-app.js can be
+ * loaded and poked at under node. It records everything the app sends. */
+
+var mock = {
+    listeners: {},
+    messages: [],
+    requests: [],
+    storage: {},
+    status: 200,      /* What the timeline API answers with. */
+    tokenError: null, /* Set this to make getTimelineToken() fail. */
+};
+
+global.Pebble = {
+    addEventListener: function( name, callback ){
+        mock.listeners[name] = callback;
+    },
+    sendAppMessage: function( message ){
+        mock.messages.push(message);
+    },
+    getTimelineToken: function( success, failure ){
+        if ( mock.tokenError !== null )
+            failure(mock.tokenError);
+        else
+            success("mock-token");
+    },
+};
+
+global.localStorage = {
+    getItem: function( key ){
+        return ( key in mock.storage ) ? mock.storage[key] : null;
+    },
+    setItem: function( key, value ){
+        mock.storage[key] = String(value);
+    },
+};
+
+/* Requests finish as soon as they're sent, with mock.status. */
+global.XMLHttpRequest = function(){
+    var self = this;
+    var request = { headers: {} };
+    this.open = function( method, url ){
+        request.method = method;
+        request.url = url;
+    };
+    this.setRequestHeader = function( name, value ){
+        request.headers[name] = value;
+    };
+    this.send = function( body ){
+        request.body = body;
+        mock.requests.push(request);
+        self.status = mock.status;
+        self.onload();
+    };
+};
+
+/* Fire one of the app's event listeners, like the phone would. */
+mock.fire = function( name, event ){
+    mock.listeners[name](event);
+};
+
+module.exports = mock;
@@ -0,0 +1,153 @@
+/* Tests for the reminder scheduling in pebble-js-app.js. */
+
+var assert = require("assert");
+var mock = require("./pebble-mock.js");
+var app = require("../../src/js/pebble-js-app.js");
+
+var EVENT_COUNT = 114;
+var DATA_VERSION = 201406171;
+
+/* Build a reminder bitset like the watch sends. */
+function packReminders( reminders ){
+    var bits = [];
+    for ( var index = 0 ; index < Math.ceil(EVENT_COUNT / 8) ; index++ )
+        bits.push(0);
+    reminders.forEach(function( index ){
+        bits[Math.floor(index / 8)] |= 1 << (index % 8);
+    });
+    return bits;
+}
+
+/*****************************************************************************/
+
+/* Bits map straight to event indexes, and stray bits past the end are ignored. */
+assert.deepEqual(app.unpackReminders(packReminders([])), []);
+assert.deepEqual(app.unpackReminders(packReminders([0, 7, 8, 113])), [0, 7, 8, 113]);
+assert.deepEqual(app.unpackReminders([0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0x04]), []);
+
+/* Event 0 is at 00:00 UTC. Ten minutes before midnight, that's tomorrow and
+ * the day after; the one after that is just past the two day window. */
+var now = new Date(Date.UTC(2014, 5, 1, 23, 50));
+var alerts = app.scheduleAlerts([0], now);
+assert.equal(alerts.length, 2);
+assert.equal(alerts[0].time.toISOString(), "2014-06-02T00:00:00.000Z");
+assert.equal(alerts[1].time.toISOString(), "2014-06-03T00:00:00.000Z");
+assert.equal(alerts[0].id, "gw2bosses-0-" + Date.UTC(2014, 5, 2));
+assert.equal(alerts[0].name, "Taidha Covington");
+
+/* Event 113 is at 23:45 UTC, which already happened today, so skip it. */
+alerts = app.scheduleAlerts([113], now);
+assert.equal(alerts.length, 2);
+assert.equal(alerts[0].time.toISOString(), "2014-06-02T23:45:00.000Z");
+assert.equal(alerts[1].time.toISOString(), "2014-06-03T23:45:00.000Z");
+
+/* An event starting right now is too late to remind about. */
+assert.equal(app.scheduleAlerts([0], new Date(Date.UTC(2014, 5, 2, 0, 0))).length, 2);
+assert.equal(app.scheduleAlerts([0], new Date(Date.UTC(2014, 5, 2, 0, 0)))[0].time.toISOString(),
+             "2014-06-03T00:00:00.000Z");
+
+/* Alerts from several events come out in time order, across month ends. */
+alerts = app.scheduleAlerts([113, 0], new Date(Date.UTC(2014, 5, 30, 23, 50)));
+assert.deepEqual(alerts.map(function( alert ){ return alert.time.toISOString(); }),
+                 ["2014-07-01T00:00:00.000Z", "2014-07-01T23:45:00.000Z",
+                  "2014-07-02T00:00:00.000Z", "2014-07-02T23:45:00.000Z"]);
+
+/* Pins get the start time, and reminders at 10 and 5 minutes before. */
+var pin = app.alertToPin(app.scheduleAlerts([0], now)[0]);
+assert.equal(pin.id, "gw2bosses-0-" + Date.UTC(2014, 5, 2));
+assert.equal(pin.time, "2014-06-02T00:00:00.000Z");
+assert.equal(pin.layout.title, "Taidha Covington");
+assert.equal(pin.layout.subtitle, "Bloodtide Coast");
+assert.deepEqual(pin.reminders.map(function( reminder ){ return reminder.time; }),
+                 ["2014-06-01T23:50:00.000Z", "2014-06-01T23:55:00.000Z"]);
+
+/* Only pins we pushed and don't want any more are stale, and pins for
+ * events that already started are left alone. */
+alerts = app.scheduleAlerts([0], now);
+assert.deepEqual(app.stalePins([], alerts, now), []);
+assert.deepEqual(app.stalePins([alerts[0].id], alerts, now), []);
+assert.deepEqual(app.stalePins(["gw2bosses-3-" + Date.UTC(2014, 5, 2, 1),
+                                "gw2bosses-3-" + Date.UTC(2014, 5, 1, 1)], alerts, now),
+                 ["gw2bosses-3-" + Date.UTC(2014, 5, 2, 1)]);
+
+/*****************************************************************************/
+
+/* The time zone offset goes to the watch when the app starts. */
+mock.fire("ready", {});
+assert.equal(mock.messages.length, 1);
+assert.ok("tz_offset" in mock.messages[0]);
+
+function requestsFor( method ){
+    return mock.requests.filter(function( request ){ return request.method === method; });
+}
+
+function pushedPins(){
+    return JSON.parse(mock.storage["pins"] || "[]");
+}
+
+/* With no token, nothing is sent and nothing is remembered. */
+mock.tokenError = "no timeline";
+mock.fire("appmessage", { payload: { reminders: packReminders([0, 1]),
+                                     data_version: DATA_VERSION } });
+assert.equal(mock.requests.length, 0);
+assert.equal(mock.storage["pins"], undefined);
+mock.tokenError = null;
+
+/* Setting reminders pushes their pins. Nothing was pushed before, so
+ * there's nothing to delete, even on the first run. */
+mock.fire("appmessage", { payload: { reminders: packReminders([0, 1]),
+                                     data_version: DATA_VERSION } });
+assert.ok(requestsFor("PUT").length >= 2);
+assert.equal(requestsFor("DELETE").length, 0);
+assert.equal(requestsFor("PUT")[0].headers["X-User-Token"], "mock-token");
+requestsFor("PUT").forEach(function( request ){
+    assert.ok(/gw2bosses-[01]-/.test(request.url));
+});
+assert.equal(pushedPins().length, requestsFor("PUT").length);
+
+/* The same list again doesn't push anything twice. */
+mock.requests = [];
+mock.fire("appmessage", { payload: { reminders: packReminders([0, 1]),
+                                     data_version: DATA_VERSION } });
+assert.equal(mock.requests.length, 0);
+
+/* Clearing one deletes only its pins, and keeps the other. */
+var before = pushedPins().length;
+mock.fire("appmessage", { payload: { reminders: packReminders([1]),
+                                     data_version: DATA_VERSION } });
+assert.ok(requestsFor("DELETE").length > 0);
+assert.equal(requestsFor("PUT").length, 0);
+requestsFor("DELETE").forEach(function( request ){
+    assert.ok(/gw2bosses-0-/.test(request.url));
+});
+assert.equal(pushedPins().length, before - requestsFor("DELETE").length);
+
+/* If the token fails while clearing, the pins are still remembered, so
+ * they get deleted on the next update that works. */
+mock.requests = [];
+mock.tokenError = "no timeline";
+mock.fire("appmessage", { payload: { reminders: packReminders([]),
+                                     data_version: DATA_VERSION } });
+assert.equal(mock.requests.length, 0);
+assert.ok(pushedPins().length > 0);
+mock.tokenError = null;
+mock.fire("appmessage", { payload: { reminders: packReminders([]),
+                                     data_version: DATA_VERSION } });
+assert.ok(requestsFor("DELETE").length > 0);
+assert.equal(pushedPins().length, 0);
+
+/* Pins the timeline turned down aren't remembered as pushed. */
+mock.requests = [];
+mock.status = 500;
+mock.fire("appmessage", { payload: { reminders: packReminders([2]),
+                                     data_version: DATA_VERSION } });
+assert.ok(requestsFor("PUT").length > 0);
+assert.equal(pushedPins().length, 0);
+mock.status = 200;
+
+/* A reminder list from a different event table is ignored. */
+mock.requests = [];
+mock.fire("appmessage", { payload: { reminders: packReminders([2]), data_version: 1 } });
+assert.equal(mock.requests.length, 0);
+
+console.log("pebble-js-app.js: all tests passed.");
@@ -0,0 +1,28 @@
+/* Do-nothing versions of the Pebble SDK functions declared in pebble.h.
+ * Tests can change the stub_* variables to steer them. */
+
+#include "pebble.h"
+
+bool stub_clock_24h = true;
+size_t stub_heap_used = 0;
+size_t stub_heap_free = 0;
+int stub_vibes = 0;
+
+bool clock_is_24h_style( void ){ return stub_clock_24h; }
+void vibes_short_pulse( void ){ stub_vibes++; }
+void vibes_double_pulse( void ){ stub_vibes++; }
+
+bool persist_exists( const uint32_t key ){ return false; }
+int persist_get_size( const uint32_t key ){ return 0; }
+int32_t persist_read_int( const uint32_t key ){ return 0; }
+status_t persist_write_int( const uint32_t key, const int32_t value ){ return S_SUCCESS; }
+int persist_read_data( const uint32_t key, void *buffer, const size_t size ){ return 0; }
+int persist_write_data( const uint32_t key, const void *data, const size_t size ){ return size; }
+
+AppMessageResult app_message_outbox_begin( DictionaryIterator **iterator ){ return APP_MSG_BUSY; }
+AppMessageResult app_message_outbox_send( void ){ return APP_MSG_OK; }
+int dict_write_int32( DictionaryIterator *iter, const uint32_t key, const int32_t value ){ return 0; }
+int dict_write_data( DictionaryIterator *iter, const uint32_t key, const uint8_t *data, const uint16_t size ){ return 0; }
+
+size_t heap_bytes_used( void ){ return stub_heap_used; }
+size_t heap_bytes_free( void ){ return stub_heap_free; }
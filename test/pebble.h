@@ -0,0 +1,52 @@
+/* Just enough of the Pebble SDK to build parts of the app on a normal
+ * computer for testing. Only what the tested files actually use is here,
+ * and the functions are stubbed out in pebble-stubs.c. */
+
+#ifndef _TEST_PEBBLE_H
+#define _TEST_PEBBLE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+typedef struct { int16_t x, y; } GPoint;
+typedef struct { int16_t w, h; } GSize;
+typedef struct { GPoint origin; GSize size; } GRect;
+
+typedef struct Layer Layer;
+typedef struct Window Window;
+typedef struct MenuLayer MenuLayer;
+
+typedef enum { APP_LOG_LEVEL_ERROR, APP_LOG_LEVEL_WARNING,
+               APP_LOG_LEVEL_INFO, APP_LOG_LEVEL_DEBUG } AppLogLevel;
+#define APP_LOG(level, ...) (fprintf(stderr, __VA_ARGS__), fputc('\n', stderr))
+
+typedef int status_t;
+#define S_SUCCESS 0
+
+typedef enum { APP_MSG_OK = 0, APP_MSG_BUSY = 64 } AppMessageResult;
+typedef struct DictionaryIterator DictionaryIterator;
+
+bool clock_is_24h_style( void );
+void vibes_short_pulse( void );
+void vibes_double_pulse( void );
+
+bool persist_exists( const uint32_t key );
+int persist_get_size( const uint32_t key );
+int32_t persist_read_int( const uint32_t key );
+status_t persist_write_int( const uint32_t key, const int32_t value );
+int persist_read_data( const uint32_t key, void *buffer, const size_t size );
+int persist_write_data( const uint32_t key, const void *data, const size_t size );
+
+AppMessageResult app_message_outbox_begin( DictionaryIterator **iterator );
+AppMessageResult app_message_outbox_send( void );
+int dict_write_int32( DictionaryIterator *iter, const uint32_t key, const int32_t value );
+int dict_write_data( DictionaryIterator *iter, const uint32_t key, const uint8_t *data, const uint16_t size );
+
+size_t heap_bytes_used( void );
+size_t heap_bytes_free( void );
+
+#endif /* #ifndef _TEST_PEBBLE_H */
@@ -0,0 +1,148 @@
+/* Checks the menu rows, with and without simultaneous events grouped. */
+
+#include "gw2bosses.h"
+#include <assert.h>
+#include <stdlib.h>
+
+/* Set the timers as of the given UTC time on some ordinary day. */
+static void set_time( const int hour, const int min ){
+    struct tm utc = { 0 };
+
+    utc.tm_year = 114;
+    utc.tm_mon = 5;
+    utc.tm_mday = 1;
+    utc.tm_hour = hour;
+    utc.tm_min = min;
+    update_event_times(&utc);
+}
+
+/* Returns true if the row's first event starts at the given time. */
+static bool row_starts_at( const bool active, const uint8_t row,
+                           const uint8_t hour, const uint8_t min ){
+    const struct event *event = get_event_group_info(active, row, 0);
+    return ( event->hour == hour && event->min == min ) ? true : false;
+}
+
+/*****************************************************************************/
+
+static void check_counts( void ){
+    uint8_t row = 0;
+
+    /* 15:00 has two events, and grouping leaves 96 rows in all. */
+    set_event_grouping(false);
+    set_time(15, 3);
+    assert(get_event_count(true) == 2);
+    assert(get_event_count(false) == 112);
+    for ( row = 0 ; row < get_event_count(false) ; row++ )
+        assert(get_event_group_size(false, row) == 1);
+
+    set_event_grouping(true);
+    assert(get_event_count(true) == 1);
+    assert(get_event_count(false) == 95);
+    assert(get_event_group_size(true, 0) == 2);
+    assert(row_starts_at(true, 0, 15, 0) == true);
+    assert(get_event_group_info(true, 0, 1)->hour == 15);
+    assert(get_event_group_info(true, 0, 1)->min == 0);
+
+    /* Every grouped row starts at a different time. */
+    for ( row = 1 ; row < get_event_count(false) ; row++ )
+        assert(get_event_timer(row) > get_event_timer(row - 1));
+}
+
+static void check_wrap( void ){
+    uint8_t count = 0;
+
+    set_event_grouping(true);
+
+    /* The upcoming rows wrap past midnight, back to 14:45. */
+    set_time(15, 3);
+    count = get_event_count(false);
+    assert(row_starts_at(false, 0, 15, 15) == true);
+    assert(row_starts_at(false, count - 1, 14, 45) == true);
+
+    /* Just before midnight, the first upcoming row is the first group,
+     * so the active row has to wrap backwards to the last one. */
+    set_time(23, 50);
+    assert(get_event_count(true) == 1);
+    assert(row_starts_at(true, 0, 23, 45) == true);
+    assert(row_starts_at(false, 0, 0, 0) == true);
+    assert(get_event_group_size(false, 0) == 2);
+}
+
+static void check_find_by_timer( void ){
+    uint8_t count = 0;
+    uint8_t row = 0;
+
+    set_event_grouping(true);
+    set_time(15, 3);
+    count = get_event_count(false);
+
+    assert(find_event_by_timer(0) == 0);
+    assert(find_event_by_timer(24 * 60 * 60) == count);
+    for ( row = 0 ; row < count ; row++ ){
+        assert(find_event_by_timer(get_event_timer(row)) == row);
+        assert(find_event_by_timer(get_event_timer(row) + 1) == row + 1);
+    }
+
+    /* Ungrouped, simultaneous events have the same timer, so the
+     * first one is found. 00:00 has two events. */
+    set_event_grouping(false);
+    count = get_event_count(false);
+    for ( row = 0 ; row < count ; row++ )
+        if ( row_starts_at(false, row, 0, 0) == true )
+            break;
+    assert(row + 1 < count);
+    assert(find_event_by_timer(get_event_timer(row + 1)) == row);
+}
+
+static void check_find_reminder( void ){
+    uint8_t count = 0;
+    uint8_t row = 0;
+
+    set_event_grouping(true);
+    set_time(15, 3);
+    count = get_event_count(false);
+
+    assert(find_event_reminder(0) == count);
+
+    /* Toggling a grouped row sets every event in it. */
+    toggle_event_reminder(false, 10);
+    assert(get_event_reminder(false, 10) == true);
+    assert(find_event_reminder(0) == 10);
+    assert(find_event_reminder(10) == 10);
+    assert(find_event_reminder(11) == count);
+
+    /* The last row has wrapped around to the start of the table. */
+    toggle_event_reminder(false, count - 1);
+    assert(find_event_reminder(11) == count - 1);
+    toggle_event_reminder(false, count - 1);
+
+    /* 23:00 has two events. Setting just one of them ungrouped still
+     * marks the grouped row, and toggling the row then clears both. */
+    toggle_event_reminder(false, 10);
+    set_event_grouping(false);
+    count = get_event_count(false);
+    for ( row = 0 ; row < count ; row++ )
+        if ( row_starts_at(false, row, 23, 0) == true )
+            break;
+    toggle_event_reminder(false, row + 1);
+    assert(get_event_reminder(false, row) == false);
+    assert(get_event_reminder(false, row + 1) == true);
+
+    set_event_grouping(true);
+    row = find_event_reminder(0);
+    assert(row_starts_at(false, row, 23, 0) == true);
+    assert(get_event_reminder(false, row) == true);
+    toggle_event_reminder(false, row);
+    assert(find_event_reminder(0) == get_event_count(false));
+}
+
+int main( void ){
+    check_counts();
+    check_wrap();
+    check_find_by_timer();
+    check_find_reminder();
+
+    printf("event: all tests passed.\n");
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,108 @@
+/* Checks format_timer() and format_clock() against the snprintf() formats
+ * they replaced, and with --bench, times the two against each other. */
+
+#include "gw2bosses.h"
+#include <assert.h>
+#include <stdlib.h>
+
+#define BENCH_ROUNDS 20
+
+/* The old menu_draw_row() countdown format. */
+static uint8_t snprintf_timer( char *buffer, const uint32_t time ){
+    if ( time >= 3600 )
+        snprintf(buffer, 9, "%"PRIu32":%02"PRIu32":%02"PRIu32,
+                 time / 3600, (time / 60) % 60, time % 60);
+    else
+        snprintf(buffer, 9, "%"PRIu32":%02"PRIu32, time / 60, time % 60);
+    return strlen(buffer);
+}
+
+/* The old start time format, minus the noon bug it had in 12-hour style. */
+static uint8_t snprintf_clock( char *buffer, const int hour, const int min, const bool is_24h ){
+    if ( is_24h == true )
+        snprintf(buffer, 9, "@%02d:%02d", hour, min);
+    else
+        snprintf(buffer, 9, "%d:%02d %s", ( hour % 12 == 0 ) ? 12 : hour % 12,
+                 min, ( hour < 12 ) ? "AM" : "PM");
+    return strlen(buffer);
+}
+
+/*****************************************************************************/
+
+static void check_formats( void ){
+    char expect[9] = { 0 };
+    char actual[9] = { 0 };
+    uint32_t time = 0;
+    int hour = 0;
+    int min = 0;
+
+    /* Every timer a row can show; up to a day away. */
+    for ( time = 0 ; time <= 24 * 60 * 60 ; time++ ){
+        uint8_t length = format_timer(actual, time);
+        assert(length == snprintf_timer(expect, time));
+        assert(strcmp(actual, expect) == 0);
+    }
+
+    /* Every minute of the day, in both clock styles. */
+    for ( hour = 0 ; hour < 24 ; hour++ ){
+        for ( min = 0 ; min < 60 ; min++ ){
+            assert(format_clock(actual, hour, min, true) ==
+                   snprintf_clock(expect, hour, min, true));
+            assert(strcmp(actual, expect) == 0);
+            assert(format_clock(actual, hour, min, false) ==
+                   snprintf_clock(expect, hour, min, false));
+            assert(strcmp(actual, expect) == 0);
+        }
+    }
+
+    /* This used to come out as 0:00 PM. */
+    format_clock(actual, 12, 0, false);
+    assert(strcmp(actual, "12:00 PM") == 0);
+
+    printf("format: all tests passed.\n");
+}
+
+/*****************************************************************************/
+
+/* Run a formatter over a day's worth of timers and start times, like
+ * scrolling through the menu a lot, and return the time it took. */
+static double bench( const bool use_snprintf ){
+    char buffer[9] = { 0 };
+    volatile uint32_t sink = 0;
+    clock_t start = clock();
+    uint32_t time = 0;
+    int round = 0;
+
+    for ( round = 0 ; round < BENCH_ROUNDS ; round++ ){
+        for ( time = 0 ; time < 24 * 60 * 60 ; time++ ){
+            if ( use_snprintf == true ){
+                sink += snprintf_timer(buffer, time);
+                sink += snprintf_clock(buffer, (time / 60) % 24, time % 60, time & 1);
+            } else {
+                sink += format_timer(buffer, time);
+                sink += format_clock(buffer, (time / 60) % 24, time % 60, time & 1);
+            }
+        }
+    }
+
+    return (double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+static void run_bench( void ){
+    double calls = (double)BENCH_ROUNDS * 24 * 60 * 60;
+    double old_time = bench(true);
+    double new_time = bench(false);
+
+    printf("snprintf:      %6.1f ns per row\n", (old_time / calls) * 1e9);
+    printf("format_*():    %6.1f ns per row\n", (new_time / calls) * 1e9);
+    printf("speedup:       %6.1fx\n", old_time / new_time);
+}
+
+int main( int argc, char **argv ){
+    check_formats();
+
+    if ( argc > 1 && strcmp(argv[1], "--bench") == 0 )
+        run_bench();
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,73 @@
+/* Checks the limits of the memory pool and the heap peak. The budgets
+ * are checked at build time, with BUILD_ASSERT(). */
+
+#include "gw2bosses.h"
+#include <assert.h>
+#include <stdlib.h>
+
+extern size_t stub_heap_used;
+extern size_t stub_heap_free;
+
+/*****************************************************************************/
+
+static void check_pool( void ){
+    void *blocks[MEMORY_POOL_BLOCKS] = { NULL };
+    uint8_t index = 0;
+    uint8_t other = 0;
+
+    /* Too big for a block is always refused. */
+    assert(memory_pool_alloc(MEMORY_POOL_BLOCK_SIZE + 1) == NULL);
+    assert(get_memory_pool_peak() == 0);
+
+    /* Every block can be handed out, and they don't overlap. */
+    for ( index = 0 ; index < MEMORY_POOL_BLOCKS ; index++ ){
+        blocks[index] = memory_pool_alloc(MEMORY_POOL_BLOCK_SIZE);
+        assert(blocks[index] != NULL);
+        memset(blocks[index], index + 1, MEMORY_POOL_BLOCK_SIZE);
+        for ( other = 0 ; other < index ; other++ )
+            assert(abs((char *)blocks[index] - (char *)blocks[other]) >= MEMORY_POOL_BLOCK_SIZE);
+    }
+    assert(get_memory_pool_peak() == MEMORY_POOL_BLOCKS);
+
+    /* Then there aren't any more. */
+    assert(memory_pool_alloc(1) == NULL);
+
+    /* Freeing one lets it be used again, and freeing twice is harmless. */
+    memory_pool_free(blocks[0]);
+    memory_pool_free(blocks[0]);
+    assert(memory_pool_alloc(1) == blocks[0]);
+    assert(memory_pool_alloc(1) == NULL);
+
+    /* Nobody stepped on anybody else's block. */
+    for ( index = 1 ; index < MEMORY_POOL_BLOCKS ; index++ )
+        assert(((uint8_t *)blocks[index])[MEMORY_POOL_BLOCK_SIZE - 1] == index + 1);
+
+    for ( index = 0 ; index < MEMORY_POOL_BLOCKS ; index++ )
+        memory_pool_free(blocks[index]);
+    assert(get_memory_pool_peak() == MEMORY_POOL_BLOCKS);
+}
+
+static void check_heap_peak( void ){
+    /* The peak follows the highest sample, and not the latest one. */
+    stub_heap_used = 1000;
+    memory_sample();
+    stub_heap_used = 3000;
+    memory_sample();
+    stub_heap_used = 2000;
+    memory_sample();
+    assert(get_memory_heap_peak() == 3000);
+
+    /* Reports take a sample too. */
+    stub_heap_used = 4000;
+    stub_heap_free = 20000;
+    memory_report();
+    assert(get_memory_heap_peak() == 4000);
+}
+
+int main( void ){
+    check_pool();
+    check_heap_peak();
+
+    printf("memory: all tests passed.\n");
+    return EXIT_SUCCESS;
+}